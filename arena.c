@@ -0,0 +1,133 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+#include "jobs.h"
+
+// Spill block header, its memory follows (the header size keeps it ARENA_ALIGN aligned)
+struct Arena_Spill {
+    Arena_Spill* next;
+    size_t capacity;
+    size_t used;
+    size_t padding;
+};
+
+// One arena per job worker, 0 being the main thread (which also runs jobs as worker 0)
+static Arena frame_arenas[JOBS_MAX_THREADS + 1];
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void* checked_malloc(size_t bytes) {
+    void* memory = malloc(bytes);
+    if (!memory) {
+        printf("arena_alloc(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Return `bytes` of ARENA_ALIGN aligned memory that stays valid until the next arena_reset()
+void* arena_alloc(Arena* arena, size_t bytes) {
+    bytes = align_up(bytes ? bytes : 1, ARENA_ALIGN);
+    arena->frame_bytes += bytes;
+    if (arena->used + bytes <= arena->capacity) {
+        void* memory = arena->base + arena->used;
+        arena->used += bytes;
+        return memory;
+    }
+
+    Arena_Spill* spill = arena->spill;
+    if (!spill || spill->used + bytes > spill->capacity) {
+        size_t capacity = bytes > ARENA_MIN_BLOCK ? bytes : ARENA_MIN_BLOCK;
+        spill = (Arena_Spill*)checked_malloc(sizeof(Arena_Spill) + capacity);
+        spill->next = arena->spill;
+        spill->capacity = capacity;
+        spill->used = 0;
+        arena->spill = spill;
+        arena->heap_allocs++;
+    }
+    void* memory = (unsigned char*)(spill + 1) + spill->used;
+    spill->used += bytes;
+    return memory;
+}
+
+// Forget everything allocated since the last reset. Only does heap work after a frame that spilled: the
+// block is then regrown (with some headroom) to hold the whole frame.
+void arena_reset(Arena* arena) {
+    if (arena->frame_bytes > arena->high_water) {
+        arena->high_water = arena->frame_bytes;
+    }
+    if (arena->spill) {
+        while (arena->spill) {
+            Arena_Spill* next = arena->spill->next;
+            free(arena->spill);
+            arena->spill = next;
+        }
+        free(arena->base);
+        arena->capacity = align_up(arena->frame_bytes + arena->frame_bytes / 4, ARENA_MIN_BLOCK);
+        arena->base = (unsigned char*)checked_malloc(arena->capacity);
+        arena->heap_allocs++;
+    }
+    arena->used = 0;
+    arena->frame_bytes = 0;
+}
+
+void arena_free(Arena* arena) {
+    while (arena->spill) {
+        Arena_Spill* next = arena->spill->next;
+        free(arena->spill);
+        arena->spill = next;
+    }
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+    arena->frame_bytes = 0;
+}
+
+// The frame arena of job worker `worker` (0 = main thread). Memory from it lasts until frame_arenas_reset().
+Arena* frame_arena(int worker) {
+    return &frame_arenas[worker];
+}
+
+// Called once at the end of every frame, while no jobs are running
+void frame_arenas_reset(void) {
+    for (int i = 0; i <= JOBS_MAX_THREADS; ++i) {
+        arena_reset(&frame_arenas[i]);
+    }
+}
+
+void frame_arenas_free(void) {
+    for (int i = 0; i <= JOBS_MAX_THREADS; ++i) {
+        arena_free(&frame_arenas[i]);
+    }
+}
+
+// Bytes handed out by all frame arenas so far this frame
+size_t frame_arenas_used(void) {
+    size_t total = 0;
+    for (int i = 0; i <= JOBS_MAX_THREADS; ++i) {
+        total += frame_arenas[i].frame_bytes;
+    }
+    return total;
+}
+
+// Sum of the largest frame each arena has seen (the current one included)
+size_t frame_arenas_high_water(void) {
+    size_t total = 0;
+    for (int i = 0; i <= JOBS_MAX_THREADS; ++i) {
+        const Arena* arena = &frame_arenas[i];
+        total += arena->frame_bytes > arena->high_water ? arena->frame_bytes : arena->high_water;
+    }
+    return total;
+}
+
+size_t frame_arenas_heap_allocs(void) {
+    size_t total = 0;
+    for (int i = 0; i <= JOBS_MAX_THREADS; ++i) {
+        total += frame_arenas[i].heap_allocs;
+    }
+    return total;
+}
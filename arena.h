@@ -0,0 +1,38 @@
+// arena.h - per-frame linear (bump) allocators for 3dsdl
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+
+#define ARENA_ALIGN 16               // every allocation is aligned to this
+#define ARENA_MIN_BLOCK (64 * 1024)  // smallest block an arena mallocs
+
+// An allocation that doesn't fit the arena's block goes to a spill block for the rest of the frame. At the
+// next reset the spills are freed and the block is regrown to cover the whole frame, so once the frame size
+// settles an arena never touches the heap again.
+typedef struct Arena_Spill Arena_Spill;
+
+typedef struct {
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+    Arena_Spill* spill;
+    size_t frame_bytes;  // bytes handed out since the last reset (block and spills)
+    size_t high_water;   // largest frame_bytes seen at a reset
+    size_t heap_allocs;  // mallocs so far, for spotting heap traffic
+} Arena;
+
+// Carve `count` values of `type` out of `arena`
+#define ARENA_ALLOC_ARRAY(arena, type, count) ((type*)arena_alloc((arena), (count) * sizeof(type)))
+
+// Prototypes
+void* arena_alloc(Arena* arena, size_t bytes);
+void arena_reset(Arena* arena);
+void arena_free(Arena* arena);
+Arena* frame_arena(int worker);
+void frame_arenas_reset(void);
+void frame_arenas_free(void);
+size_t frame_arenas_used(void);
+size_t frame_arenas_high_water(void);
+size_t frame_arenas_heap_allocs(void);
+
+#endif
@@ -0,0 +1,190 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "bench.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const char* STAGE_NAMES[BENCH_STAGE_COUNT] = { "transform", "clip", "sort", "submit", "overlay", "present" };
+
+// Control points of the camera loop, relative to the path center (x, height above it, z)
+static const Point_3D PATH_POINTS[] = {
+    {  36.0f,  8.0f,   0.0f },
+    {  24.0f, 14.0f,  28.0f },
+    {   0.0f, 20.0f,  40.0f },
+    { -30.0f, 12.0f,  22.0f },
+    { -40.0f,  6.0f,   0.0f },
+    { -20.0f, 10.0f, -30.0f },
+    {   0.0f, 24.0f, -18.0f },
+    {  20.0f, 16.0f, -38.0f },
+};
+#define PATH_POINT_COUNT (sizeof(PATH_POINTS) / sizeof(PATH_POINTS[0]))
+
+// Milliseconds since `since`, which is then moved up to now (so consecutive laps time consecutive stages)
+double bench_lap(Uint64* since) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    double ms = (double)(now - *since) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    *since = now;
+    return ms;
+}
+
+// Uniform Catmull-Rom interpolation between p1 and p2
+static float catmull_rom(float p0, float p1, float p2, float p3, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+static Point_3D path_point(float t) {
+    float s = t * (float)PATH_POINT_COUNT;
+    int segment = (int)floorf(s);
+    float u = s - (float)segment;
+    const Point_3D* p0 = &PATH_POINTS[(segment - 1 + PATH_POINT_COUNT) % PATH_POINT_COUNT];
+    const Point_3D* p1 = &PATH_POINTS[segment % PATH_POINT_COUNT];
+    const Point_3D* p2 = &PATH_POINTS[(segment + 1) % PATH_POINT_COUNT];
+    const Point_3D* p3 = &PATH_POINTS[(segment + 2) % PATH_POINT_COUNT];
+    return (Point_3D){
+        catmull_rom(p0->x, p1->x, p2->x, p3->x, u),
+        catmull_rom(p0->y, p1->y, p2->y, p3->y, u),
+        catmull_rom(p0->z, p1->z, p2->z, p3->z, u)
+    };
+}
+
+// Camera on the closed benchmark loop at t in [0, 1), looking along the path and a bit down
+void bench_camera_path(float t, Point_3D center, Point_3D* position, float* yaw, float* pitch) {
+    t -= floorf(t);
+    Point_3D here = path_point(t);
+    Point_3D ahead = path_point(fmodf(t + 0.01f, 1.0f));
+    position->x = center.x + here.x;
+    position->y = center.y + here.y;
+    position->z = center.z + here.z;
+
+    float dx = ahead.x - here.x;
+    float dz = ahead.z - here.z;
+    float heading = atan2f(dx, dz) * (180.0f / (float)M_PI);
+    *yaw = heading < 0.0f ? heading + 360.0f : heading;
+    *pitch = 20.0f;
+}
+
+void bench_init(Bench_Recorder* recorder, size_t frames) {
+    recorder->frame_count = 0;
+    recorder->frame_capacity = frames;
+    recorder->stage_ms = (double*)malloc(frames * BENCH_STAGE_COUNT * sizeof(double));
+    recorder->frame_ms = (double*)malloc(frames * sizeof(double));
+    recorder->face_counts = (size_t*)malloc(frames * sizeof(size_t));
+    if (!recorder->stage_ms || !recorder->frame_ms || !recorder->face_counts) {
+        printf("bench_init(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void bench_free(Bench_Recorder* recorder) {
+    free(recorder->stage_ms);
+    free(recorder->frame_ms);
+    free(recorder->face_counts);
+    recorder->stage_ms = NULL;
+    recorder->frame_ms = NULL;
+    recorder->face_counts = NULL;
+    recorder->frame_count = recorder->frame_capacity = 0;
+}
+
+// Store one frame's timings (frames past the capacity are dropped)
+void bench_record(Bench_Recorder* recorder, const double stage_ms[BENCH_STAGE_COUNT], double frame_ms, size_t face_count) {
+    if (recorder->frame_count >= recorder->frame_capacity) {
+        return;
+    }
+    size_t frame = recorder->frame_count++;
+    memcpy(&recorder->stage_ms[frame * BENCH_STAGE_COUNT], stage_ms, BENCH_STAGE_COUNT * sizeof(double));
+    recorder->frame_ms[frame] = frame_ms;
+    recorder->face_counts[frame] = face_count;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const double* sorted, size_t count, double p) {
+    size_t rank = (size_t)ceil(p / 100.0 * (double)count);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Write the mean/p50/p95/p99/max summary of one column as a JSON object
+static void write_summary(FILE* file, const char* name, const double* values, size_t stride, size_t count, double* scratch, bool last) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        scratch[i] = values[i * stride];
+        sum += scratch[i];
+    }
+    qsort(scratch, count, sizeof(double), compare_double);
+    fprintf(file, "    \"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+        name, sum / (double)count, percentile(scratch, count, 50.0), percentile(scratch, count, 95.0),
+        percentile(scratch, count, 99.0), scratch[count - 1], last ? "" : ",");
+}
+
+// Write <prefix>.csv (one row per frame) and <prefix>.json (percentile summaries). Returns false on I/O errors.
+bool bench_write(const Bench_Recorder* recorder, const char* prefix, const char* label) {
+    size_t count = recorder->frame_count;
+    if (count == 0) {
+        printf("No benchmark frames recorded\n");
+        return false;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s.csv", prefix);
+    FILE* csv = fopen(path, "w");
+    if (!csv) {
+        printf("Could not write %s\n", path);
+        return false;
+    }
+    fprintf(csv, "frame");
+    for (int s = 0; s < BENCH_STAGE_COUNT; ++s) {
+        fprintf(csv, ",%s_ms", STAGE_NAMES[s]);
+    }
+    fprintf(csv, ",frame_ms,faces\n");
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(csv, "%zu", i);
+        for (int s = 0; s < BENCH_STAGE_COUNT; ++s) {
+            fprintf(csv, ",%.4f", recorder->stage_ms[i * BENCH_STAGE_COUNT + s]);
+        }
+        fprintf(csv, ",%.4f,%zu\n", recorder->frame_ms[i], recorder->face_counts[i]);
+    }
+    bool ok = fclose(csv) == 0;
+
+    snprintf(path, sizeof(path), "%s.json", prefix);
+    FILE* json = fopen(path, "w");
+    if (!json) {
+        printf("Could not write %s\n", path);
+        return false;
+    }
+    double* scratch = (double*)malloc(count * sizeof(double));
+    if (!scratch) {
+        printf("bench_write(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(json, "{\n  \"label\": \"%s\",\n  \"frames\": %zu,\n  \"ms\": {\n", label, count);
+    for (int s = 0; s < BENCH_STAGE_COUNT; ++s) {
+        write_summary(json, STAGE_NAMES[s], recorder->stage_ms + s, BENCH_STAGE_COUNT, count, scratch, false);
+    }
+    write_summary(json, "frame", recorder->frame_ms, 1, count, scratch, true);
+    fprintf(json, "  }\n}\n");
+    ok = (fclose(json) == 0) && ok;
+
+    // Short summary on stdout too
+    for (size_t i = 0; i < count; ++i) {
+        scratch[i] = recorder->frame_ms[i];
+    }
+    qsort(scratch, count, sizeof(double), compare_double);
+    printf("Bench (%s): %zu frames, frame ms p50 %.3f, p95 %.3f, p99 %.3f, max %.3f -> %s.csv/.json\n",
+        label, count, percentile(scratch, count, 50.0), percentile(scratch, count, 95.0),
+        percentile(scratch, count, 99.0), scratch[count - 1], prefix);
+    free(scratch);
+    return ok;
+}
@@ -0,0 +1,37 @@
+// bench.h - scripted camera-path benchmark with per-stage frame timings for 3dsdl
+#ifndef BENCH_H
+#define BENCH_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL2/SDL.h>
+#include "data_structures.h"
+
+// Frame stages that get timed separately
+typedef enum {
+    BENCH_TRANSFORM, // chunk mesh faces to camera space
+    BENCH_CLIP,      // near-plane clip, projection and render face build
+    BENCH_SORT,      // painter's sort
+    BENCH_SUBMIT,    // vertex upload, SDL_RenderGeometry and outlines
+    BENCH_OVERLAY,   // ImGui frame and draw
+    BENCH_PRESENT,   // SDL_RenderPresent
+    BENCH_STAGE_COUNT
+} Bench_Stage;
+
+// Per-frame timings (in ms) of a whole run
+typedef struct {
+    double* stage_ms; // frame_capacity rows of BENCH_STAGE_COUNT values
+    double* frame_ms;
+    size_t* face_counts;
+    size_t frame_count;
+    size_t frame_capacity;
+} Bench_Recorder;
+
+// Prototypes
+double bench_lap(Uint64* since);
+void bench_camera_path(float t, Point_3D center, Point_3D* position, float* yaw, float* pitch);
+void bench_init(Bench_Recorder* recorder, size_t frames);
+void bench_free(Bench_Recorder* recorder);
+void bench_record(Bench_Recorder* recorder, const double stage_ms[BENCH_STAGE_COUNT], double frame_ms, size_t face_count);
+bool bench_write(const Bench_Recorder* recorder, const char* prefix, const char* label);
+
+#endif
@@ -0,0 +1,234 @@
+// bench_cube_map.c - standalone microbenchmark for Cube_Map and the collision query built on it
+// Measures insert, hit/miss lookup, delete churn, iteration and aabb_intersects_map throughput for random
+// and spatially coherent keys at several map sizes, plus the probe length distribution of lookups.
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "data_structures.h"
+
+#define BENCH_MIN_SIZE 1000
+#define BENCH_MAX_SIZE 10000000
+#define BENCH_MAX_CHURN 1000000   // delete/insert pairs per size (caps the cubes allocated up front)
+#define BENCH_MAX_PROBE_SAMPLES 1000000
+#define PROBE_BUCKETS 7
+
+typedef enum {
+    PATTERN_RANDOM,   // keys scattered uniformly over a huge volume
+    PATTERN_COHERENT  // a solid box of cells filled in x/z/y order, like terrain chunks
+} Key_Pattern;
+
+static const char* PATTERN_NAMES[] = { "random", "coherent" };
+static const char* PROBE_BUCKET_NAMES[PROBE_BUCKETS] = { "1", "2", "3", "4", "5-8", "9-16", "17+" };
+
+static uint64_t rng_state = 0x853C49E6748FEA9BULL;
+
+// xorshift64*, good enough to scatter keys and shuffle
+static uint64_t next_random(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static double now_seconds(void) {
+    return (double)SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+}
+
+static void* checked_malloc(size_t bytes) {
+    void* memory = malloc(bytes);
+    if (!memory) {
+        printf("checked_malloc(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Side of the smallest cube-ish box with at least `count` cells
+static int box_side(size_t count) {
+    int side = 1;
+    while ((size_t)side * (size_t)side * (size_t)side < count) {
+        side++;
+    }
+    return side;
+}
+
+// Fill `keys` with `count` distinct keys following `pattern`. `shift` moves the whole set out of the way,
+// which gives keys that are guaranteed to miss.
+static void make_keys(Cube_Key* keys, size_t count, Key_Pattern pattern, int shift) {
+    if (pattern == PATTERN_RANDOM) {
+        // An odd multiplier is a bijection on 63 bits, so splitting the product into three 21-bit axes gives
+        // distinct keys scattered all over a 2^21 cube
+        uint64_t salt = next_random();
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t r = (((uint64_t)i + salt) * 0x9E3779B97F4A7C15ULL) & 0x7FFFFFFFFFFFFFFFULL;
+            keys[i] = (Cube_Key){
+                .x = (int)(r & 0x1FFFFF) - 0x100000,
+                .y = (int)((r >> 21) & 0x1FFFFF) - 0x100000 + shift,
+                .z = (int)((r >> 42) & 0x1FFFFF) - 0x100000
+            };
+        }
+        return;
+    }
+
+    int side = box_side(count);
+    size_t i = 0;
+    for (int x = 0; x < side && i < count; ++x) {
+        for (int z = 0; z < side && i < count; ++z) {
+            for (int y = 0; y < side && i < count; ++y) {
+                keys[i++] = (Cube_Key){ .x = x - side / 2, .y = y + shift, .z = z - side / 2 };
+            }
+        }
+    }
+}
+
+static Cube* new_cube(Cube_Map* map) {
+    Cube* cube = cube_map_new_cube(map);
+    memset(cube, 0, sizeof(Cube));
+    return cube;
+}
+
+static void print_rate(const char* pattern, size_t size, const char* operation, size_t ops, double seconds) {
+    printf("%-9s %9zu  %-14s %8.1f ns/op  %8.2f Mops/s\n", pattern, size, operation,
+        seconds * 1e9 / (double)ops, (double)ops / seconds / 1e6);
+}
+
+// Histogram of lookup probe lengths over (a sample of) `keys`
+static void print_probes(const Cube_Map* map, const Cube_Key* keys, size_t count, const char* label) {
+    size_t buckets[PROBE_BUCKETS] = {0};
+    size_t samples = count < BENCH_MAX_PROBE_SAMPLES ? count : BENCH_MAX_PROBE_SAMPLES;
+    size_t step = count / samples;
+    size_t total = 0;
+    size_t longest = 0;
+    for (size_t s = 0; s < samples; ++s) {
+        size_t probes = cube_map_probe_length(map, keys[s * step]);
+        total += probes;
+        if (probes > longest) {
+            longest = probes;
+        }
+        int bucket = probes <= 4 ? (int)probes - 1 : probes <= 8 ? 4 : probes <= 16 ? 5 : 6;
+        buckets[bucket < 0 ? 0 : bucket]++;
+    }
+    printf("          probes (%s): mean %.2f, max %zu |", label, (double)total / (double)samples, longest);
+    for (int b = 0; b < PROBE_BUCKETS; ++b) {
+        printf(" %s:%.1f%%", PROBE_BUCKET_NAMES[b], 100.0 * (double)buckets[b] / (double)samples);
+    }
+    printf("\n");
+}
+
+static void run_size(size_t size, Key_Pattern pattern) {
+    const char* name = PATTERN_NAMES[pattern];
+    Cube_Key* keys = (Cube_Key*)checked_malloc(size * sizeof(Cube_Key));
+    Cube_Key* misses = (Cube_Key*)checked_malloc(size * sizeof(Cube_Key));
+    make_keys(keys, size, pattern, 0);
+    make_keys(misses, size, pattern, pattern == PATTERN_RANDOM ? 0x400000 : box_side(size) + 1);
+
+    // Cubes are allocated (from the map's pool) up front so only the map itself gets timed
+    Cube_Map map;
+    init_cube_map(&map, 0);
+    Cube** cubes = (Cube**)checked_malloc(size * sizeof(Cube*));
+    for (size_t i = 0; i < size; ++i) {
+        cubes[i] = new_cube(&map);
+    }
+
+    // Insert (from the minimum capacity, so rehashes are included)
+    double start = now_seconds();
+    for (size_t i = 0; i < size; ++i) {
+        cube_map_add(&map, keys[i], cubes[i]);
+    }
+    print_rate(name, size, "insert", size, now_seconds() - start);
+    free(cubes);
+
+    // Lookups, hits in insertion order and misses
+    size_t found = 0;
+    start = now_seconds();
+    for (size_t i = 0; i < size; ++i) {
+        found += cube_map_get(&map, keys[i]) != NULL;
+    }
+    print_rate(name, size, "lookup hit", size, now_seconds() - start);
+
+    start = now_seconds();
+    for (size_t i = 0; i < size; ++i) {
+        found += cube_map_get(&map, misses[i]) != NULL;
+    }
+    print_rate(name, size, "lookup miss", size, now_seconds() - start);
+    if (found != size) {
+        printf("run_size(): %zu lookups found out of %zu expected. Exiting!\n", found, size);
+        exit(EXIT_FAILURE);
+    }
+    print_probes(&map, keys, size, "hit");
+    print_probes(&map, misses, size, "miss");
+
+    // Iteration over every slot, the way the renderer and mesher walk the maps
+    start = now_seconds();
+    size_t visited = 0;
+    size_t capacity = cube_map_capacity(&map);
+    for (size_t i = 0; i < capacity; ++i) {
+        const Cube_Map_Entry* entry = cube_map_entry_at(&map, i);
+        if (entry && entry->occupied) {
+            visited += (size_t)entry->cube->color.a + 1;
+        }
+    }
+    double seconds = now_seconds() - start;
+    printf("%-9s %9zu  %-14s %8.1f ns/cube %7.1f ns/slot (%zu slots, checksum %zu)\n", name, size, "iterate",
+        seconds * 1e9 / (double)size, seconds * 1e9 / (double)capacity, capacity, visited);
+
+    // Collision queries: player-sized boxes scattered over the keys (half land on cubes, half next to them)
+    const size_t queries = size < 1000000 ? size : 1000000;
+    size_t hits = 0;
+    start = now_seconds();
+    for (size_t q = 0; q < queries; ++q) {
+        Cube_Key key = (q & 1) ? misses[(q * 7919) % size] : keys[(q * 7919) % size];
+        AABB box = player_aabb((float)key.x * 2.0f, (float)key.y * 2.0f + 1.5f, (float)key.z * 2.0f, 0.3f, 1.8f, 1.6f);
+        hits += aabb_intersects_map(&map, box, 2.0f, 0.0f, 0.0f, 0.0f);
+    }
+    seconds = now_seconds() - start;
+    printf("%-9s %9zu  %-14s %8.1f ns/op  %8.2f Mops/s (%.0f%% hit)\n", name, size, "aabb query",
+        seconds * 1e9 / (double)queries, (double)queries / seconds / 1e6, 100.0 * (double)hits / (double)queries);
+
+    // Delete churn: remove a random live key and insert a fresh one, keeping the size constant
+    size_t churn = size < BENCH_MAX_CHURN ? size : BENCH_MAX_CHURN;
+    Cube** churn_cubes = (Cube**)checked_malloc(churn * sizeof(Cube*));
+    for (size_t i = 0; i < churn; ++i) {
+        churn_cubes[i] = new_cube(&map);
+    }
+    start = now_seconds();
+    for (size_t i = 0; i < churn; ++i) {
+        size_t victim = (size_t)(next_random() % size);
+        cube_map_remove(&map, keys[victim]);
+        keys[victim] = misses[i];
+        cube_map_add(&map, keys[victim], churn_cubes[i]);
+    }
+    print_rate(name, size, "delete churn", churn, now_seconds() - start);
+    print_probes(&map, keys, size, "hit after churn");
+    free(churn_cubes);
+
+    // Teardown, one free per slab
+    start = now_seconds();
+    free_cube_map(&map);
+    seconds = now_seconds() - start;
+    printf("%-9s %9zu  %-14s %8.3f ms\n", name, size, "teardown", seconds * 1e3);
+    free(keys);
+    free(misses);
+}
+
+int main(int argc, char** argv) {
+    size_t max_size = BENCH_MAX_SIZE;
+    if (argc > 1) {
+        max_size = (size_t)strtoull(argv[1], NULL, 10);
+    }
+    if (max_size < BENCH_MIN_SIZE) {
+        printf("Usage: %s [max size, at least %d (default %d)]\n", argv[0], BENCH_MIN_SIZE, BENCH_MAX_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    printf("Cube_Map microbenchmark (entry %zu bytes, max load 0.7)\n", sizeof(Cube_Map_Entry));
+    for (size_t size = BENCH_MIN_SIZE; size <= max_size; size *= 10) {
+        for (int pattern = PATTERN_RANDOM; pattern <= PATTERN_COHERENT; ++pattern) {
+            run_size(size, (Key_Pattern)pattern);
+        }
+    }
+    return EXIT_SUCCESS;
+}
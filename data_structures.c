@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "data_structures.h"
 
 #include <math.h>
@@ -57,6 +58,13 @@ AABB player_aabb(float px, float py, float pz, float radius, float height, float
     return box;
 }
 
+// Check if two AABBs overlap (touching faces don't count).
+bool aabb_overlaps(AABB a, AABB b) {
+    return a.min_x < b.max_x && a.max_x > b.min_x &&
+           a.min_y < b.max_y && a.max_y > b.min_y &&
+           a.min_z < b.max_z && a.max_z > b.min_z;
+}
+
 // Check if an AABB intersects with any cubes in the map.
 bool aabb_intersects_map(const Cube_Map* map, AABB box, float step, float offset_x, float offset_y, float offset_z) {
     int min_x = world_to_grid_index_floor(box.min_x, step, offset_x);
@@ -121,6 +129,48 @@ static size_t next_pow2(size_t v) {
     return v + 1;
 }
 
+// Hand out an uninitialized cube, reusing a released one if there is any
+Cube* cube_pool_alloc(Cube_Pool* pool) {
+    Cube* cube = pool->free_list;
+    if (cube) {
+        // Released cubes hold the next free cube's address in their first bytes (cubes are only 4 byte aligned)
+        memcpy(&pool->free_list, cube, sizeof(Cube*));
+        pool->live++;
+        return cube;
+    }
+    if (pool->slab_count == 0 || pool->slab_used == CUBE_SLAB_SIZE) {
+        if (pool->slab_count == pool->slab_capacity) {
+            pool->slab_capacity = pool->slab_capacity ? pool->slab_capacity * 2 : 16;
+            pool->slabs = (Cube**)realloc(pool->slabs, pool->slab_capacity * sizeof(Cube*));
+        }
+        Cube* slab = (Cube*)malloc(CUBE_SLAB_SIZE * sizeof(Cube));
+        if (!pool->slabs || !slab) {
+            printf("cube_pool_alloc(): Memory allocation failed. Exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        pool->slabs[pool->slab_count++] = slab;
+        pool->slab_used = 0;
+    }
+    pool->live++;
+    return &pool->slabs[pool->slab_count - 1][pool->slab_used++];
+}
+
+// Give a cube from cube_pool_alloc() back to its pool
+void cube_pool_release(Cube_Pool* pool, Cube* cube) {
+    memcpy(cube, &pool->free_list, sizeof(Cube*));
+    pool->free_list = cube;
+    pool->live--;
+}
+
+// Free every slab, and with them every cube the pool ever handed out
+void free_cube_pool(Cube_Pool* pool) {
+    for (size_t i = 0; i < pool->slab_count; ++i) {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    memset(pool, 0, sizeof(*pool));
+}
+
 // Rehash the map to a new capacity (must be power of 2)
 static void cube_map_rehash(Cube_Map* map, size_t new_capacity) {
     Cube_Map_Entry* old_entries = map->entries;
@@ -129,6 +179,7 @@ static void cube_map_rehash(Cube_Map* map, size_t new_capacity) {
     map->entries = (Cube_Map_Entry*)calloc(new_capacity, sizeof(Cube_Map_Entry));
     map->capacity = new_capacity;
     map->size = 0;
+    map->tombstones = 0;
 
     for (size_t i = 0; i < old_capacity; ++i) {
         if (old_entries[i].occupied) {
@@ -149,37 +200,44 @@ void init_cube_map(Cube_Map* map, size_t initial_capacity) {
     map->entries = (Cube_Map_Entry*)calloc(cap, sizeof(Cube_Map_Entry));
     map->capacity = cap;
     map->size = 0;
+    map->tombstones = 0;
+    memset(&map->pool, 0, sizeof(map->pool));
 }
 
-// Free the cube map's internal resources (also frees cubes)
+// Free the cube map's internal resources (also frees cubes, a slab at a time)
 void free_cube_map(Cube_Map* map) {
     if (!map) {
         return;
     }
-    if (map->entries) {
-        for (size_t i = 0; i < map->capacity; ++i) {
-            if (map->entries[i].occupied && map->entries[i].cube) {
-                free(map->entries[i].cube);
-                map->entries[i].cube = NULL;
-            }
-        }
-    }
+    free_cube_pool(&map->pool);
     free(map->entries);
     map->entries = NULL;
     map->capacity = 0;
     map->size = 0;
+    map->tombstones = 0;
 }
 
-// Add a cube in the map with the given key
+// A new (uninitialized) cube from the map's pool, to be filled in and added to the same map
+Cube* cube_map_new_cube(Cube_Map* map) {
+    if (!map) {
+        printf("cube_map_new_cube(): NULL map pointer. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    return cube_pool_alloc(&map->pool);
+}
+
+// Add a cube in the map with the given key (replacing, and releasing, the cube already there)
 bool cube_map_add(Cube_Map* map, Cube_Key key, Cube* cube) {
     if (!map || !cube) {
         printf("cube_map_add(): NULL pointer. Exiting!\n");
         exit(EXIT_FAILURE);
     }
 
-    // Load factor > 0.7 triggers resize
-    if ((map->size + 1) * 10 >= map->capacity * 7) {
-        cube_map_rehash(map, map->capacity * 2);
+    // Load factor > 0.7 (tombstones included) triggers a rehash, which only grows the map if the live entries
+    // alone are past half of that; otherwise it just clears the tombstones left behind by removals
+    if ((map->size + map->tombstones + 1) * 10 >= map->capacity * 7) {
+        bool grow = (map->size + 1) * 20 >= map->capacity * 7;
+        cube_map_rehash(map, grow ? map->capacity * 2 : map->capacity);
     }
 
     uint64_t hash = cube_key_hash(key);
@@ -195,6 +253,9 @@ bool cube_map_add(Cube_Map* map, Cube_Key key, Cube* cube) {
             } else if (!entry->tombstone) {
                 size_t target = (first_tombstone != (size_t)-1) ? first_tombstone : index;
                 map->entries[target].key = key;
+                if (target == first_tombstone) {
+                    map->tombstones--;
+                }
                 map->entries[target].cube = cube;
                 map->entries[target].occupied = true;
                 map->entries[target].tombstone = false;
@@ -202,6 +263,9 @@ bool cube_map_add(Cube_Map* map, Cube_Key key, Cube* cube) {
                 return true;
             }
         } else if (cube_key_equals(entry->key, key)) {
+            if (entry->cube && entry->cube != cube) {
+                cube_pool_release(&map->pool, entry->cube);
+            }
             entry->cube = cube;
             return true;
         }
@@ -250,10 +314,11 @@ bool cube_map_remove(Cube_Map* map, Cube_Key key) {
             entry->occupied = false;
             entry->tombstone = true;
             if (entry->cube) {
-                free(entry->cube);
+                cube_pool_release(&map->pool, entry->cube);
                 entry->cube = NULL;
             }
             map->size--;
+            map->tombstones++;
             return true;
         }
         index = (index + 1) & mask;
@@ -264,10 +329,199 @@ size_t cube_map_capacity(const Cube_Map* map) {
     return map ? map->capacity : 0;
 }
 
+// Number of slots a lookup of `key` looks at before it finds the key or gives up (for measuring clustering)
+size_t cube_map_probe_length(const Cube_Map* map, Cube_Key key) {
+    if (!map || map->capacity == 0) {
+        return 0;
+    }
+    size_t mask = map->capacity - 1;
+    size_t index = (size_t)cube_key_hash(key) & mask;
+    size_t probes = 1;
+    for (;;) {
+        const Cube_Map_Entry* entry = &map->entries[index];
+        if ((!entry->occupied && !entry->tombstone) || (entry->occupied && cube_key_equals(entry->key, key))) {
+            return probes;
+        }
+        index = (index + 1) & mask;
+        probes++;
+    }
+}
+
 // Retrieve a pointer to the entry at the given index (NULL if out of bounds)
 const Cube_Map_Entry* cube_map_entry_at(const Cube_Map* map, size_t index) {
     if (!map || index >= map->capacity) {
         return NULL;
     }
     return &map->entries[index];
-}
\ No newline at end of file
+}
+
+// Free a chunk together with its cached mesh
+static void destroy_chunk(Chunk* chunk) {
+    if (chunk) {
+        free(chunk->faces);
+        for (int level = 0; level < CHUNK_LOD_LEVELS - 1; ++level) {
+            free(chunk->lods[level].faces);
+        }
+        free(chunk);
+    }
+}
+
+// Rehash the chunk map to a new capacity (must be power of 2)
+static void chunk_map_rehash(Chunk_Map* map, size_t new_capacity) {
+    Chunk_Map_Entry* old_entries = map->entries;
+    size_t old_capacity = map->capacity;
+
+    map->entries = (Chunk_Map_Entry*)calloc(new_capacity, sizeof(Chunk_Map_Entry));
+    map->capacity = new_capacity;
+    map->size = 0;
+    map->tombstones = 0;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].occupied) {
+            chunk_map_add(map, old_entries[i].key, old_entries[i].chunk);
+        }
+    }
+
+    free(old_entries);
+}
+
+// Initialize the chunk map with a given initial capacity (will be rounded up to next power of 2)
+void init_chunk_map(Chunk_Map* map, size_t initial_capacity) {
+    if (!map) {
+        printf("init_chunk_map(): NULL map pointer. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t cap = next_pow2(initial_capacity);
+    map->entries = (Chunk_Map_Entry*)calloc(cap, sizeof(Chunk_Map_Entry));
+    map->capacity = cap;
+    map->size = 0;
+    map->tombstones = 0;
+}
+
+// Free the chunk map's internal resources (also frees chunks and their meshes)
+void free_chunk_map(Chunk_Map* map) {
+    if (!map) {
+        return;
+    }
+    if (map->entries) {
+        for (size_t i = 0; i < map->capacity; ++i) {
+            if (map->entries[i].occupied && map->entries[i].chunk) {
+                destroy_chunk(map->entries[i].chunk);
+                map->entries[i].chunk = NULL;
+            }
+        }
+    }
+    free(map->entries);
+    map->entries = NULL;
+    map->capacity = 0;
+    map->size = 0;
+    map->tombstones = 0;
+}
+
+// Add a chunk in the map with the given key
+bool chunk_map_add(Chunk_Map* map, Cube_Key key, Chunk* chunk) {
+    if (!map || !chunk) {
+        printf("chunk_map_add(): NULL pointer. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Load factor > 0.7 (tombstones included) triggers a rehash, which only grows the map if the live entries
+    // alone are past half of that; otherwise it just clears the tombstones left behind by removals
+    if ((map->size + map->tombstones + 1) * 10 >= map->capacity * 7) {
+        bool grow = (map->size + 1) * 20 >= map->capacity * 7;
+        chunk_map_rehash(map, grow ? map->capacity * 2 : map->capacity);
+    }
+
+    uint64_t hash = cube_key_hash(key);
+    size_t mask = map->capacity - 1;
+    size_t index = (size_t)hash & mask;
+    size_t first_tombstone = (size_t)-1;
+
+    for (;;) {
+        Chunk_Map_Entry* entry = &map->entries[index];
+        if (!entry->occupied) {
+            if (entry->tombstone && first_tombstone == (size_t)-1) {
+                first_tombstone = index;
+            } else if (!entry->tombstone) {
+                size_t target = (first_tombstone != (size_t)-1) ? first_tombstone : index;
+                map->entries[target].key = key;
+                if (target == first_tombstone) {
+                    map->tombstones--;
+                }
+                map->entries[target].chunk = chunk;
+                map->entries[target].occupied = true;
+                map->entries[target].tombstone = false;
+                map->size++;
+                return true;
+            }
+        } else if (cube_key_equals(entry->key, key)) {
+            entry->chunk = chunk;
+            return true;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Retrieve a chunk from the map by its key (NULL if not found)
+Chunk* chunk_map_get(const Chunk_Map* map, Cube_Key key) {
+    if (!map || map->capacity == 0) {
+        return NULL;
+    }
+    uint64_t hash = cube_key_hash(key);
+    size_t mask = map->capacity - 1;
+    size_t index = (size_t)hash & mask;
+
+    while(1) {
+        const Chunk_Map_Entry* entry = &map->entries[index];
+        if (!entry->occupied) {
+            if (!entry->tombstone) {
+                return NULL;
+            }
+        } else if (cube_key_equals(entry->key, key)) {
+            return entry->chunk;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Remove a chunk from the map by its key (returns true if removed, false if not found)
+bool chunk_map_remove(Chunk_Map* map, Cube_Key key) {
+    if (!map || map->capacity == 0) {
+        return false;
+    }
+    uint64_t hash = cube_key_hash(key);
+    size_t mask = map->capacity - 1;
+    size_t index = (size_t)hash & mask;
+
+    while(1) {
+        Chunk_Map_Entry* entry = &map->entries[index];
+        if (!entry->occupied) {
+            if (!entry->tombstone) {
+                return false;
+            }
+        } else if (cube_key_equals(entry->key, key)) {
+            entry->occupied = false;
+            entry->tombstone = true;
+            if (entry->chunk) {
+                destroy_chunk(entry->chunk);
+                entry->chunk = NULL;
+            }
+            map->size--;
+            map->tombstones++;
+            return true;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+size_t chunk_map_capacity(const Chunk_Map* map) {
+    return map ? map->capacity : 0;
+}
+
+// Retrieve a pointer to the chunk entry at the given index (NULL if out of bounds)
+const Chunk_Map_Entry* chunk_map_entry_at(const Chunk_Map* map, size_t index) {
+    if (!map || index >= map->capacity) {
+        return NULL;
+    }
+    return &map->entries[index];
+}
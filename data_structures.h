@@ -29,16 +29,86 @@ typedef struct {
     float y;
 } Projected_Point;
 
+// Most points a face (a quad) can have after frustum clipping: one more per clip plane
+#define MAX_CLIPPED_POINTS 9
+
+// How a face came out of clip_polygon_frustum
+typedef enum {
+    FRUSTUM_INSIDE,   // within the near plane and the guard band, passed through untouched
+    FRUSTUM_CLIPPED,  // clipped to the near plane and/or the guard band
+    FRUSTUM_BEHIND,   // entirely behind the near plane
+    FRUSTUM_OUTSIDE   // entirely off one side of the screen
+} Frustum_Result;
+
 // A face to be rendered, with its vertices in screen space, depth for sorting, and color.
 typedef struct {
-    SDL_Vertex verts[12];
+    SDL_Vertex verts[(MAX_CLIPPED_POINTS - 2) * 3];
     size_t vert_count;
     float depth;
-    Projected_Point line_pts[6];
+    Projected_Point line_pts[MAX_CLIPPED_POINTS];
     size_t line_count;
     SDL_Color color;
 } Render_Face;
 
+// Per-frame render pipeline counters (shown in the overlay's counters panel).
+typedef struct {
+    size_t chunks_visited;
+    size_t chunks_distance;    // chunks beyond the view distance, skipped whole
+    size_t cubes_visited;      // cubes in the visited chunks
+    size_t faces_generated;    // chunk mesh faces considered
+    size_t faces_backface;     // culled for facing away from the camera
+    size_t faces_fogged;       // faces past the view distance, in chunks that straddle it
+    size_t faces_near_clipped; // culled entirely by the near plane
+    size_t faces_offscreen;    // culled for lying outside one of the screen's edges
+    size_t faces_clipped;      // reaching past the near plane or the guard band, so clipped in camera space
+    size_t faces_drawn;
+    size_t triangles;
+    size_t vertices;
+    size_t geometry_calls;     // SDL_RenderGeometry calls
+    size_t line_calls;         // SDL_RenderDrawLine calls
+    float sort_ms;
+    size_t faces_capacity;     // sizes of this frame's face and vertex buffers
+    size_t verts_capacity;
+    size_t arena_bytes;        // frame arena memory handed out this frame
+    size_t arena_high_water;   // largest frame the arenas have held
+    size_t arena_heap_allocs;  // mallocs done by the frame arenas since the last frame
+    float render_scale;        // dynamic resolution scale, in percent
+    size_t rays;               // rays cast (ray cast backend)
+    size_t ray_hits;
+    size_t chunks_lod_2x;      // chunks drawn with cubes merged 2x2x2 / 4x4x4 (chunk LOD)
+    size_t chunks_lod_4x;
+    size_t faces_outlined;     // faces near enough to get an outline
+    size_t frames_retained;    // frames in a row the last world image was reused for (0 = rendered)
+    float input_latency_ms;    // from the oldest mouse motion the camera took to the present that showed it
+} Render_Counters;
+
+// How the world gets drawn.
+typedef enum {
+    RENDER_BACKEND_SDL,     // painter's sorted SDL_RenderGeometry fills plus SDL line outlines
+    RENDER_BACKEND_RASTER,  // tile-binned software rasterizer with a z-buffer
+    RENDER_BACKEND_RAYCAST  // one ray per pixel (or block of pixels) through the grid
+} Render_Backend;
+
+// Render switches that can be flipped at runtime (in the overlay's counters panel).
+typedef struct {
+    Render_Backend backend;
+    bool backface_culling;
+    int ray_block;          // pixels per ray side in RENDER_BACKEND_RAYCAST (1 or 2)
+    bool chunk_lod;         // draw far chunks with merged cubes
+    float view_distance;    // world units
+    bool fog;
+    bool retained;          // reuse the last world image while nothing changes (see retained.h)
+    bool late_latch;        // take the newest mouse look again right before rendering (see input.h)
+} Render_Settings;
+
+// A chunk mesh face in camera space, waiting to be clipped and projected.
+typedef struct {
+    Camera_Point points[4];
+    SDL_Color color;        // outline color
+    SDL_Color lit[4];       // fill color at each corner
+    bool outline;
+} View_Face;
+
 // 3D point structure.
 typedef struct {
     float x;
@@ -77,25 +147,144 @@ typedef struct {
     bool tombstone;
 } Cube_Map_Entry;
 
-// Hash map for storing cubes by their keys.
+// Cubes per slab of a cube pool
+#define CUBE_SLAB_SIZE 4096
+
+// Slab allocator for cubes: cubes are carved in order from contiguous slabs (so cubes created together sit
+// together in memory), released ones go on a free list threaded through their own storage, and everything is
+// released at once, one free per slab.
+typedef struct {
+    Cube** slabs;
+    size_t slab_count;
+    size_t slab_capacity;
+    size_t slab_used;  // cubes handed out from the last slab
+    Cube* free_list;
+    size_t live;
+} Cube_Pool;
+
+// Hash map for storing cubes by their keys. The map owns its cubes, which must come from cube_map_new_cube().
 typedef struct {
     Cube_Map_Entry* entries;
     size_t capacity;
     size_t size;
+    size_t tombstones; // removed slots, they count towards the load factor until the next rehash
+    Cube_Pool pool;
 } Cube_Map;
 
+// Chunks group CHUNK_SIZE^3 grid cells, so whole regions of empty space can be skipped at once.
+#define CHUNK_SHIFT 4
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+#define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+
+// Dense contents of one chunk (cells indexed by x + CHUNK_SIZE * (y + CHUNK_SIZE * z), alpha 0 = empty),
+// used to hand whole chunks to the world without touching it cube by cube (e.g. from worker threads).
+typedef struct {
+    Cube_Key key;
+    size_t cube_count;
+    SDL_Color cells[CHUNK_VOLUME];
+} Chunk_Data;
+
+// A cube face exposed to air, cached in its chunk's mesh. dir indexes the face table in world.c. lit holds the
+// color at each corner with the face's lighting (directional shade and ambient occlusion) baked in.
+typedef struct {
+    Point_3D points[4];
+    SDL_Color color;
+    SDL_Color lit[4];
+    int dir;
+} Chunk_Face;
+
+#define CHUNK_LOD_LEVELS 3 // full detail, then cubes merged 2x2x2 and 4x4x4 at a time
+
+// A coarser mesh of a chunk, built from merged cubes (see world_mesh_chunk).
+typedef struct {
+    Chunk_Face* faces;
+    size_t face_count;
+    size_t face_capacity;
+} Chunk_Lod;
+
+// A chunk of the grid. Its key is in chunk coordinates (grid coordinate / CHUNK_SIZE, rounded down).
+// The mesh only holds faces not hidden by a neighbouring cube and is rebuilt when mesh_dirty is set,
+// together with the coarser levels of detail in lods. lod is the level the chunk was last drawn at.
+// dirty marks chunks edited since they were loaded (or generated), which are the only ones that need saving.
+typedef struct {
+    Cube_Key key;
+    size_t cube_count;
+    Chunk_Face* faces;
+    size_t face_count;
+    size_t face_capacity;
+    Chunk_Lod lods[CHUNK_LOD_LEVELS - 1];
+    int lod;
+    bool mesh_dirty;
+    bool dirty;
+} Chunk;
+
+// Entry in the chunk hash map.
+typedef struct {
+    Cube_Key key;
+    Chunk* chunk;
+    bool occupied;
+    bool tombstone;
+} Chunk_Map_Entry;
+
+// Hash map for storing chunks by their chunk coordinates.
+typedef struct {
+    Chunk_Map_Entry* entries;
+    size_t capacity;
+    size_t size;
+    size_t tombstones;
+} Chunk_Map;
+
+// A ray in world space (dir doesn't need to be normalized).
+typedef struct {
+    Point_3D origin;
+    Point_3D dir;
+    float max_distance;
+} Ray;
+
+// Result of a ray query against the grid: the first solid cell hit, the normal of the face the ray entered
+// through (all zero if the ray started inside a cube) and the distance along the ray in world units.
+typedef struct {
+    bool hit;
+    Cube_Key key;
+    int normal_x;
+    int normal_y;
+    int normal_z;
+    float distance;
+} Ray_Hit;
+
+// Yaw/pitch rotation of the camera, computed once per frame and shared by every transformed point.
+typedef struct {
+    float yaw_cos;
+    float yaw_sin;
+    float pitch_cos;
+    float pitch_sin;
+} Camera_Basis;
+
 // Prototypes
 void make_cube(Cube* cube, float size, Point_3D center, SDL_Color color);
 int world_to_grid_coord(float world, float step, float offset);
 int world_to_grid_index_floor(float world, float step, float offset);
 AABB player_aabb(float px, float py, float pz, float radius, float height, float eye_height);
+bool aabb_overlaps(AABB a, AABB b);
 bool aabb_intersects_map(const Cube_Map* map, AABB box, float step, float offset_x, float offset_y, float offset_z);
+Cube* cube_pool_alloc(Cube_Pool* pool);
+void cube_pool_release(Cube_Pool* pool, Cube* cube);
+void free_cube_pool(Cube_Pool* pool);
 void init_cube_map(Cube_Map* map, size_t initial_capacity);
 void free_cube_map(Cube_Map* map);
+Cube* cube_map_new_cube(Cube_Map* map);
 bool cube_map_add(Cube_Map* map, Cube_Key key, Cube* cube);
 Cube* cube_map_get(const Cube_Map* map, Cube_Key key);
 bool cube_map_remove(Cube_Map* map, Cube_Key key);
 size_t cube_map_capacity(const Cube_Map* map);
+size_t cube_map_probe_length(const Cube_Map* map, Cube_Key key);
 const Cube_Map_Entry* cube_map_entry_at(const Cube_Map* map, size_t index);
+void init_chunk_map(Chunk_Map* map, size_t initial_capacity);
+void free_chunk_map(Chunk_Map* map);
+bool chunk_map_add(Chunk_Map* map, Cube_Key key, Chunk* chunk);
+Chunk* chunk_map_get(const Chunk_Map* map, Cube_Key key);
+bool chunk_map_remove(Chunk_Map* map, Cube_Key key);
+size_t chunk_map_capacity(const Chunk_Map* map);
+const Chunk_Map_Entry* chunk_map_entry_at(const Chunk_Map* map, size_t index);
 
 #endif
@@ -0,0 +1,73 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <SDL2/SDL.h>
+#include "dynres.h"
+#include "settings.h"
+
+#define SMOOTHING 0.1        // weight of the newest frame in the moving average
+#define SETTLE_FRAMES 10     // frames between scale changes, so each change shows up in the average first
+#define MAX_STEP_DOWN 0.90f  // largest relative change per step: drop fast, climb back slowly
+#define MAX_STEP_UP 1.05f
+
+bool dynres_init(Dynamic_Resolution* dynres, SDL_Renderer* renderer, double budget_ms) {
+    dynres->target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, WIDTH, HEIGHT);
+    if (!dynres->target) {
+        printf("dynres_init(): SDL_CreateTexture Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureScaleMode(dynres->target, SDL_ScaleModeLinear);
+    dynres->scale = 1.0f;
+    dynres->budget_ms = budget_ms;
+    dynres->smoothed_ms = 0.0;
+    dynres->settle_frames = SETTLE_FRAMES;
+    return true;
+}
+
+void dynres_free(Dynamic_Resolution* dynres) {
+    if (dynres->target) {
+        SDL_DestroyTexture(dynres->target);
+        dynres->target = NULL;
+    }
+}
+
+// Redirect drawing into the scaled part of the target texture
+void dynres_begin(Dynamic_Resolution* dynres, SDL_Renderer* renderer) {
+    SDL_SetRenderTarget(renderer, dynres->target);
+    SDL_RenderSetScale(renderer, dynres->scale, dynres->scale);
+}
+
+// Back to the window, and stretch what was drawn over it
+void dynres_end(Dynamic_Resolution* dynres, SDL_Renderer* renderer) {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+    SDL_Rect source = { 0, 0, (int)ceilf(WIDTH * dynres->scale), (int)ceilf(HEIGHT * dynres->scale) };
+    SDL_RenderCopy(renderer, dynres->target, &source, NULL);
+}
+
+// Feed the controller the time the last frame took (without the frame cap wait). Fill cost goes with the pixel
+// count, so the scale moves by the square root of how far off the budget the average is.
+void dynres_update(Dynamic_Resolution* dynres, double frame_ms) {
+    if (dynres->smoothed_ms <= 0.0) {
+        dynres->smoothed_ms = frame_ms;
+    } else {
+        dynres->smoothed_ms += (frame_ms - dynres->smoothed_ms) * SMOOTHING;
+    }
+    if (dynres->settle_frames > 0) {
+        dynres->settle_frames--;
+        return;
+    }
+
+    // Aim a bit under the budget, and leave the scale alone while the frame time is close enough
+    double ratio = dynres->budget_ms * DYNRES_HEADROOM / dynres->smoothed_ms;
+    if (ratio > 0.95 && ratio < 1.1) {
+        return;
+    }
+    float step = sqrtf((float)ratio);
+    step = fminf(fmaxf(step, MAX_STEP_DOWN), MAX_STEP_UP);
+    float scale = fminf(fmaxf(dynres->scale * step, DYNRES_MIN_SCALE), 1.0f);
+    if (scale != dynres->scale) {
+        dynres->scale = scale;
+        dynres->settle_frames = SETTLE_FRAMES;
+    }
+}
@@ -0,0 +1,25 @@
+// dynres.h - dynamic resolution scaling for 3dsdl
+#ifndef DYNRES_H
+#define DYNRES_H
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+// The world is drawn into the top-left `scale` part of a WIDTH x HEIGHT target texture (through the renderer
+// scale, so nothing upstream needs to know), which is then stretched over the window. A feedback controller
+// picks the scale that keeps the frame time within budget.
+typedef struct {
+    SDL_Texture* target;
+    float scale;          // linear render scale, DYNRES_MIN_SCALE..1
+    double budget_ms;     // frame time the controller aims for
+    double smoothed_ms;   // exponential moving average of the frame time
+    int settle_frames;    // frames to wait before the next change shows up in smoothed_ms
+} Dynamic_Resolution;
+
+// Prototypes
+bool dynres_init(Dynamic_Resolution* dynres, SDL_Renderer* renderer, double budget_ms);
+void dynres_free(Dynamic_Resolution* dynres);
+void dynres_begin(Dynamic_Resolution* dynres, SDL_Renderer* renderer);
+void dynres_end(Dynamic_Resolution* dynres, SDL_Renderer* renderer);
+void dynres_update(Dynamic_Resolution* dynres, double frame_ms);
+
+#endif
@@ -1,10 +1,12 @@
 // Simple C-callable wrapper to use Dear ImGui with an SDL_Renderer-based backend.
 #include <algorithm>
+#include <cfloat>
 #include <cstdlib>
 #include <iostream>
 #include <string>
 #include <SDL2/SDL.h>
 #include "imgui_overlay.h"
+#include "profiler.h"
 #include "imgui/imgui.h"
 #include "imgui/backends/imgui_impl_sdl2.h"
 #include "imgui/backends/imgui_impl_sdlrenderer2.h"
@@ -12,6 +14,8 @@
 extern "C" {
 
 static SDL_Renderer* aux_renderer = nullptr;
+static bool has_platform = false;   // false when headless (no window for the SDL2 platform backend)
+static Uint64 last_frame_counter = 0;
 
 struct Overlay_Stats {
     int fps;
@@ -21,9 +25,54 @@ struct Overlay_Stats {
     float speed;
     size_t cube_count;
     size_t map_capacity;
+    bool target_hit;
+    int target_x, target_y, target_z;
+    float target_distance;
+    bool streaming;
+    size_t resident_chunks;
+    size_t loading_chunks;
+    bool capturing;
 };
 
-static Overlay_Stats stats = {0,0,0,0,0,0,0,0,0,0};
+static Overlay_Stats stats = {0,0,0,0,0,0,0,0,0,0,false,0,0,0,0,false,0,0,false};
+
+// Counters panel state: one history row per counter
+enum {
+    COUNTER_CHUNKS, COUNTER_CHUNKS_DISTANCE, COUNTER_CUBES, COUNTER_FACES, COUNTER_BACKFACE, COUNTER_FOGGED,
+    COUNTER_NEAR, COUNTER_OFFSCREEN, COUNTER_CLIPPED, COUNTER_DRAWN, COUNTER_TRIANGLES, COUNTER_VERTICES,
+    COUNTER_GEOMETRY_CALLS, COUNTER_LINE_CALLS, COUNTER_SORT_MS, COUNTER_FACES_CAPACITY, COUNTER_VERTS_CAPACITY,
+    COUNTER_ARENA_BYTES, COUNTER_ARENA_HIGH_WATER, COUNTER_ARENA_HEAP_ALLOCS, COUNTER_RENDER_SCALE, COUNTER_RAYS,
+    COUNTER_RAY_HITS, COUNTER_LOD_2X, COUNTER_LOD_4X, COUNTER_OUTLINED, COUNTER_RETAINED, COUNTER_INPUT_LATENCY,
+    COUNTER_COUNT
+};
+static const char* COUNTER_NAMES[COUNTER_COUNT] = {
+    "chunks visited", "culled: distance", "cubes visited", "faces generated", "culled: backface", "culled: fog",
+    "culled: near clip", "culled: offscreen", "guard band clipped", "faces drawn", "triangles", "vertices",
+    "RenderGeometry calls", "RenderDrawLine calls", "sort ms", "faces buffer", "vertex buffer", "frame arena KiB",
+    "arena high water KiB", "arena mallocs", "render scale %", "rays", "ray hits", "chunks at 2x LOD",
+    "chunks at 4x LOD", "faces outlined", "frames retained", "input latency ms"
+};
+static const int COUNTER_HISTORY = 120;
+static float counter_history[COUNTER_COUNT][COUNTER_HISTORY];
+static int counter_history_pos = 0;
+static bool counters_visible = false;
+static Render_Settings* render_settings = nullptr;
+
+// Profiler panel state
+static bool profiler_visible = false;
+static int profiler_frames_shown = 4;              // frames across the timeline
+static const int PROFILER_AVERAGE_FRAMES = 60;     // window of the rolling averages
+static Profile_Event profile_events[PROFILE_RING_SIZE];
+
+// Rolling per-scope totals of the main thread
+struct Scope_Average {
+    const char* name;
+    int depth;
+    Uint64 first_start;
+    double total_ms;
+    double max_ms;
+};
+static const int MAX_SCOPE_AVERAGES = 64;
 
 void overlay_init(SDL_Window* window, SDL_Renderer* renderer) {
     IMGUI_CHECKVERSION();
@@ -42,24 +91,34 @@ void overlay_init(SDL_Window* window, SDL_Renderer* renderer) {
         std::exit(EXIT_FAILURE);
     }
     std::string font_path = base_str + "../assets/DejaVuSansMono.ttf";
-    ImFont* font = ImGui::GetIO().Fonts->AddFontFromFileTTF(font_path.c_str(), 18.0f);
+    SDL_RWops* font_file = SDL_RWFromFile(font_path.c_str(), "rb"); // check first, ImGui asserts on missing files
+    ImFont* font = nullptr;
+    if (font_file) {
+        SDL_RWclose(font_file);
+        font = ImGui::GetIO().Fonts->AddFontFromFileTTF(font_path.c_str(), 18.0f);
+    }
     if (font) {
         ImGui::GetIO().FontDefault = font;
         std::cout << "Font loaded from: " << font_path << std::endl;
     } else {
-        std::cout << "AddFontFromFileTTF() failed to load font at path: " << font_path << std::endl;
-        exit(EXIT_FAILURE);
+        std::cout << "AddFontFromFileTTF() failed to load font at path: " << font_path << ", using the built-in font" << std::endl;
+        ImGui::GetIO().Fonts->AddFontDefault();
     }
 
-    // Initialize platform/renderer backends for SDL renderer
-    ImGui_ImplSDL2_InitForSDLRenderer(window, renderer);
+    // Initialize platform/renderer backends for SDL renderer (no platform backend without a window)
+    has_platform = window != nullptr;
+    if (has_platform) {
+        ImGui_ImplSDL2_InitForSDLRenderer(window, renderer);
+    }
     ImGui_ImplSDLRenderer2_Init(renderer);
     aux_renderer = renderer;
 }
 
 void overlay_process_event(SDL_Event* event) {
     // Forward events to ImGui
-    ImGui_ImplSDL2_ProcessEvent(event);
+    if (has_platform) {
+        ImGui_ImplSDL2_ProcessEvent(event);
+    }
 }
 
 void overlay_set_stats(float x, float y, float z, float yaw, float pitch, float fov, size_t cube_map_size, size_t cube_map_capacity) {
@@ -70,9 +129,257 @@ void overlay_set_stats(float x, float y, float z, float yaw, float pitch, float
     stats.map_capacity = cube_map_capacity;
 }
 
+void overlay_set_target(bool hit, int x, int y, int z, float distance) {
+    stats.target_hit = hit;
+    stats.target_x = x; stats.target_y = y; stats.target_z = z;
+    stats.target_distance = distance;
+}
+
+void overlay_set_streaming(size_t resident_chunks, size_t loading_chunks) {
+    stats.streaming = true;
+    stats.resident_chunks = resident_chunks;
+    stats.loading_chunks = loading_chunks;
+}
+
+// Push this frame's render counters into the history. The panel edits `settings` in place.
+void overlay_set_counters(const Render_Counters* counters, Render_Settings* settings) {
+    const float values[COUNTER_COUNT] = {
+        (float)counters->chunks_visited, (float)counters->chunks_distance, (float)counters->cubes_visited,
+        (float)counters->faces_generated, (float)counters->faces_backface, (float)counters->faces_fogged,
+        (float)counters->faces_near_clipped, (float)counters->faces_offscreen, (float)counters->faces_clipped,
+        (float)counters->faces_drawn, (float)counters->triangles, (float)counters->vertices,
+        (float)counters->geometry_calls, (float)counters->line_calls, counters->sort_ms,
+        (float)counters->faces_capacity, (float)counters->verts_capacity, (float)counters->arena_bytes / 1024.0f,
+        (float)counters->arena_high_water / 1024.0f, (float)counters->arena_heap_allocs, counters->render_scale,
+        (float)counters->rays, (float)counters->ray_hits, (float)counters->chunks_lod_2x,
+        (float)counters->chunks_lod_4x, (float)counters->faces_outlined, (float)counters->frames_retained,
+        counters->input_latency_ms
+    };
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        counter_history[i][counter_history_pos] = values[i];
+    }
+    counter_history_pos = (counter_history_pos + 1) % COUNTER_HISTORY;
+    render_settings = settings;
+}
+
+void overlay_toggle_counters() {
+    counters_visible = !counters_visible;
+}
+
+void overlay_set_capturing(bool capturing) {
+    stats.capturing = capturing;
+}
+
+void overlay_toggle_profiler() {
+    profiler_visible = !profiler_visible;
+}
+
+// Latest value and a history plot of every render counter
+static void draw_counters_panel() {
+    ImGui::SetNextWindowPos(ImVec2(10, 330), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Render counters (F2)", &counters_visible, ImGuiWindowFlags_AlwaysAutoResize);
+    if (render_settings) {
+        int backend = (int)render_settings->backend;
+        ImGui::RadioButton("SDL geometry", &backend, RENDER_BACKEND_SDL);
+        ImGui::SameLine();
+        ImGui::RadioButton("Software rasterizer", &backend, RENDER_BACKEND_RASTER);
+        ImGui::SameLine();
+        ImGui::RadioButton("Ray cast", &backend, RENDER_BACKEND_RAYCAST);
+        render_settings->backend = (Render_Backend)backend;
+        if (render_settings->backend == RENDER_BACKEND_RAYCAST) {
+            bool blocks = render_settings->ray_block > 1;
+            ImGui::Checkbox("One ray per 2x2 pixels", &blocks);
+            render_settings->ray_block = blocks ? 2 : 1;
+        } else {
+            ImGui::Checkbox("Backface culling", &render_settings->backface_culling);
+            ImGui::SameLine();
+            ImGui::Checkbox("Chunk LOD", &render_settings->chunk_lod);
+        }
+        ImGui::SetNextItemWidth(200);
+        ImGui::SliderFloat("View distance", &render_settings->view_distance, 32.0f, 512.0f, "%.0f");
+        ImGui::SameLine();
+        ImGui::Checkbox("Fog", &render_settings->fog);
+        ImGui::Checkbox("Reuse the last frame while nothing changes", &render_settings->retained);
+        ImGui::Checkbox("Late-latch mouse look", &render_settings->late_latch);
+    }
+    int latest = (counter_history_pos + COUNTER_HISTORY - 1) % COUNTER_HISTORY;
+    if (ImGui::BeginTable("counters", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", COUNTER_NAMES[i]);
+            ImGui::TableNextColumn();
+            if (i == COUNTER_SORT_MS || i == COUNTER_INPUT_LATENCY) {
+                ImGui::Text("%10.3f", counter_history[i][latest]);
+            } else {
+                ImGui::Text("%10.0f", counter_history[i][latest]);
+            }
+            ImGui::TableNextColumn();
+            ImGui::PushID(i);
+            ImGui::PlotLines("", counter_history[i], COUNTER_HISTORY, counter_history_pos, NULL, 0.0f, FLT_MAX, ImVec2(200, 24));
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+// Stable color per scope name
+static ImU32 scope_color(const char* name) {
+    unsigned hash = 2166136261u;
+    for (const char* c = name; *c; ++c) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    return (ImU32)ImColor::HSV((float)(hash % 360) / 360.0f, 0.55f, 0.85f);
+}
+
+// Timeline of the last few complete frames, one lane per thread with nested scopes stacked below their
+// parents, followed by the main thread's scope averages over the last PROFILER_AVERAGE_FRAMES frames
+static void draw_profiler_panel() {
+    ImGui::SetNextWindowPos(ImVec2(10, 330), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(900, 380), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler (F3)", &profiler_visible);
+    ImGui::SliderInt("Frames", &profiler_frames_shown, 1, 30);
+
+    uint32_t frame = profiler_frame();
+    if (frame <= (uint32_t)PROFILER_AVERAGE_FRAMES) {
+        ImGui::Text("Collecting...");
+        ImGui::End();
+        return;
+    }
+    const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    Uint64 view_start = profiler_frame_start(frame - (uint32_t)profiler_frames_shown);
+    Uint64 view_end = profiler_frame_start(frame); // the current frame is still running
+    if (view_end <= view_start) {
+        ImGui::End();
+        return;
+    }
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float label_width = 90.0f;
+    const float row_height = ImGui::GetTextLineHeight() + 2.0f;
+    const float timeline_x = origin.x + label_width;
+    const float timeline_width = ImGui::GetContentRegionAvail().x - label_width;
+    const double scale = timeline_width / (double)(view_end - view_start);
+    const ImVec2 mouse = ImGui::GetIO().MousePos;
+    float y = origin.y;
+
+    for (int thread = 0; thread < profiler_thread_count(); ++thread) {
+        size_t count = profiler_collect(thread, view_start, profile_events, PROFILE_RING_SIZE);
+        int lane_depth = 0;
+        draw->AddText(ImVec2(origin.x, y), IM_COL32(200, 200, 200, 255), profiler_thread_name(thread));
+        for (size_t i = 0; i < count; ++i) {
+            const Profile_Event* event = &profile_events[i];
+            if (event->start >= view_end) {
+                continue;
+            }
+            Uint64 start = event->start > view_start ? event->start : view_start;
+            Uint64 end = event->end < view_end ? event->end : view_end;
+            float x0 = timeline_x + (float)((double)(start - view_start) * scale);
+            float x1 = timeline_x + (float)((double)(end - view_start) * scale);
+            if (x1 - x0 < 1.0f) {
+                x1 = x0 + 1.0f;
+            }
+            float y0 = y + (float)event->depth * row_height;
+            ImVec2 min(x0, y0);
+            ImVec2 max(x1, y0 + row_height - 1.0f);
+            draw->AddRectFilled(min, max, scope_color(event->name));
+            if (x1 - x0 > 24.0f) {
+                draw->PushClipRect(min, max, true);
+                draw->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32(0, 0, 0, 255), event->name);
+                draw->PopClipRect();
+            }
+            if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= min.y && mouse.y < max.y) {
+                ImGui::SetTooltip("%s: %.3f ms", event->name, (double)(event->end - event->start) * ms_per_tick);
+            }
+            if (event->depth > lane_depth) {
+                lane_depth = event->depth;
+            }
+        }
+        y += (float)(lane_depth + 1) * row_height + 4.0f;
+    }
+
+    // Frame boundaries over all lanes
+    for (int f = 0; f <= profiler_frames_shown; ++f) {
+        Uint64 start = profiler_frame_start(frame - (uint32_t)f);
+        float x = timeline_x + (float)((double)(start - view_start) * scale);
+        draw->AddLine(ImVec2(x, origin.y), ImVec2(x, y), IM_COL32(255, 255, 255, 90));
+    }
+    ImGui::Dummy(ImVec2(label_width + timeline_width, y - origin.y));
+
+    // Rolling averages of the main thread's scopes
+    Scope_Average averages[MAX_SCOPE_AVERAGES];
+    int average_count = 0;
+    Uint64 average_start = profiler_frame_start(frame - (uint32_t)PROFILER_AVERAGE_FRAMES);
+    size_t count = profiler_collect(0, average_start, profile_events, PROFILE_RING_SIZE);
+    for (size_t i = 0; i < count; ++i) {
+        const Profile_Event* event = &profile_events[i];
+        if (event->start < average_start || event->end > view_end) {
+            continue;
+        }
+        double ms = (double)(event->end - event->start) * ms_per_tick;
+        int slot = 0;
+        while (slot < average_count && (averages[slot].name != event->name || averages[slot].depth != event->depth)) {
+            slot++;
+        }
+        if (slot == average_count) {
+            if (average_count == MAX_SCOPE_AVERAGES) {
+                continue;
+            }
+            averages[average_count++] = Scope_Average{event->name, event->depth, event->start, 0.0, 0.0};
+        }
+        if (event->start < averages[slot].first_start) {
+            averages[slot].first_start = event->start;
+        }
+        averages[slot].total_ms += ms;
+        if (ms > averages[slot].max_ms) {
+            averages[slot].max_ms = ms;
+        }
+    }
+    // Events are stored when scopes end (children first), listing them by start time puts every parent
+    // back in front of its children
+    std::sort(averages, averages + average_count, [](const Scope_Average& a, const Scope_Average& b) {
+        return a.first_start != b.first_start ? a.first_start < b.first_start : a.depth < b.depth;
+    });
+    ImGui::Separator();
+    ImGui::Text("Main thread, last %d frames:", PROFILER_AVERAGE_FRAMES);
+    if (ImGui::BeginTable("averages", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("scope");
+        ImGui::TableSetupColumn("avg ms/frame");
+        ImGui::TableSetupColumn("max ms");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < average_count; ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%*s%s", averages[i].depth * 2, "", averages[i].name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", averages[i].total_ms / PROFILER_AVERAGE_FRAMES);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", averages[i].max_ms);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
 void overlay_newframe() {
     ImGui_ImplSDLRenderer2_NewFrame();
-    ImGui_ImplSDL2_NewFrame();
+    if (has_platform) {
+        ImGui_ImplSDL2_NewFrame();
+    } else {
+        // What the platform backend would do: display size from the render target, delta time from the clock
+        ImGuiIO& io = ImGui::GetIO();
+        int w = 0, h = 0;
+        SDL_GetRendererOutputSize(aux_renderer, &w, &h);
+        io.DisplaySize = ImVec2((float)w, (float)h);
+        Uint64 now = SDL_GetPerformanceCounter();
+        io.DeltaTime = last_frame_counter ? (float)((double)(now - last_frame_counter) / (double)SDL_GetPerformanceFrequency()) : 1.0f / 60.0f;
+        if (io.DeltaTime <= 0.0f) {
+            io.DeltaTime = 0.00001f;
+        }
+        last_frame_counter = now;
+    }
     ImGui::NewFrame();
 
     // Small top-left overlay window
@@ -83,11 +390,33 @@ void overlay_newframe() {
     ImGui::Text("Cam. Pos.: (x:%.2f, y:%.2f, z:%.2f)", stats.x, stats.y, stats.z);
     ImGui::Text("Cam. View: (yaw:%.1f, pitch:%.1f, fov:%.1f)", stats.yaw, stats.pitch, stats.fov);
     ImGui::Text("Cube Map: (cubes:%zu, size:%zu)", stats.cube_count, stats.map_capacity);
+    if (stats.target_hit) {
+        ImGui::Text("Target: (x:%d, y:%d, z:%d, dist:%.2f)", stats.target_x, stats.target_y, stats.target_z, stats.target_distance);
+    } else {
+        ImGui::Text("Target: none");
+    }
+    if (stats.streaming) {
+        ImGui::Text("Streaming: (resident:%zu, loading:%zu)", stats.resident_chunks, stats.loading_chunks);
+    }
+    if (stats.capturing) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Capturing trace...");
+    }
     ImGui::Separator();
     ImGui::Text("Use WASD to move, mouse to look around,");
     ImGui::Text("left shift to sprint and space to jump.");
+    ImGui::Text("Left/right click to break/place blocks.");
+    ImGui::Text("F2/F3 to show render counters/the profiler,");
+    ImGui::Text("F4 to capture a trace.");
+    ImGui::Text("F5 to save the world (with --world).");
     ImGui::End();
     ImGui::PopStyleColor();
+
+    if (counters_visible) {
+        draw_counters_panel();
+    }
+    if (profiler_visible) {
+        draw_profiler_panel();
+    }
 }
 
 void overlay_render() {
@@ -97,7 +426,9 @@ void overlay_render() {
 
 void overlay_shutdown() {
     ImGui_ImplSDLRenderer2_Shutdown();
-    ImGui_ImplSDL2_Shutdown();
+    if (has_platform) {
+        ImGui_ImplSDL2_Shutdown();
+    }
     ImGui::DestroyContext();
 }
 
@@ -1,7 +1,9 @@
 #ifndef IMGUI_OVERLAY_H
 #define IMGUI_OVERLAY_H
+#include <stdbool.h>
 #include <stddef.h>
 #include <SDL2/SDL.h>
+#include "data_structures.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +15,12 @@ void overlay_newframe();
 void overlay_render();
 void overlay_shutdown();
 void overlay_set_stats(float x, float y, float z, float yaw, float pitch, float fov, size_t cube_map_size, size_t cube_map_capacity);
+void overlay_set_target(bool hit, int x, int y, int z, float distance);
+void overlay_set_streaming(size_t resident_chunks, size_t loading_chunks);
+void overlay_toggle_profiler();
+void overlay_set_capturing(bool capturing);
+void overlay_set_counters(const Render_Counters* counters, Render_Settings* settings);
+void overlay_toggle_counters();
 
 #ifdef __cplusplus
 }
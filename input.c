@@ -0,0 +1,93 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "input.h"
+#include "settings.h"
+
+// Event watch: runs from inside SDL_PumpEvents (or whichever thread pushes the event), before the event
+// reaches the queue
+static int mouse_look_watch(void* userdata, SDL_Event* event) {
+    if (event->type != SDL_MOUSEMOTION) {
+        return 0;
+    }
+    Mouse_Look* look = (Mouse_Look*)userdata;
+    SDL_LockMutex(look->lock);
+    look->dx += event->motion.xrel;
+    look->dy += event->motion.yrel;
+    if (look->first_seen == 0) {
+        look->first_seen = SDL_GetPerformanceCounter();
+    }
+    SDL_UnlockMutex(look->lock);
+    return 0;
+}
+
+void mouse_look_init(Mouse_Look* look) {
+    memset(look, 0, sizeof(*look));
+    look->lock = SDL_CreateMutex();
+    if (!look->lock) {
+        printf("mouse_look_init(): SDL_CreateMutex Error: %s. Exiting!\n", SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+    SDL_AddEventWatch(mouse_look_watch, look);
+}
+
+void mouse_look_free(Mouse_Look* look) {
+    if (look->lock) {
+        SDL_DelEventWatch(mouse_look_watch, look);
+        SDL_DestroyMutex(look->lock);
+    }
+    memset(look, 0, sizeof(*look));
+}
+
+// Pump events, then take all the motion gathered since the last call. Returns when the oldest of it came in
+// (performance counter), or 0 if there was none.
+Uint64 mouse_look_take(Mouse_Look* look, int* dx, int* dy) {
+    SDL_PumpEvents();
+    SDL_LockMutex(look->lock);
+    *dx = look->dx;
+    *dy = look->dy;
+    Uint64 first_seen = look->first_seen;
+    look->dx = 0;
+    look->dy = 0;
+    look->first_seen = 0;
+    SDL_UnlockMutex(look->lock);
+    return first_seen;
+}
+
+// Turn the camera by a mouse motion in pixels
+void mouse_look_apply(Camera* camera, int dx, int dy) {
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+    camera->yaw += (float)dx * MOUSE_SENSITIVITY;
+    if (camera->yaw > 360.0f) {
+        camera->yaw -= 360.0f;
+    } else if (camera->yaw < 0.0f) {
+        camera->yaw += 360.0f;
+    }
+    // Standard Y (not inverted)
+    camera->pitch += (float)dy * MOUSE_SENSITIVITY;
+    if (camera->pitch > PITCH_MAX) {
+        camera->pitch = PITCH_MAX;
+    }
+    if (camera->pitch < PITCH_MIN) {
+        camera->pitch = PITCH_MIN;
+    }
+}
+
+// INPUT_* bits of the keyboard state and this tick's block edit clicks
+uint16_t input_buttons(const Uint8* keystate, bool break_requested, bool place_requested) {
+    uint16_t buttons = 0;
+    buttons |= keystate[SDL_SCANCODE_W] ? INPUT_FORWARD : 0;
+    buttons |= keystate[SDL_SCANCODE_S] ? INPUT_BACK : 0;
+    buttons |= keystate[SDL_SCANCODE_A] ? INPUT_LEFT : 0;
+    buttons |= keystate[SDL_SCANCODE_D] ? INPUT_RIGHT : 0;
+    buttons |= keystate[SDL_SCANCODE_SPACE] ? INPUT_JUMP : 0;
+    buttons |= keystate[SDL_SCANCODE_LSHIFT] ? INPUT_SPRINT : 0;
+    buttons |= break_requested ? INPUT_BREAK : 0;
+    buttons |= place_requested ? INPUT_PLACE : 0;
+    return buttons;
+}
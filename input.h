@@ -0,0 +1,48 @@
+// input.h - player input: mouse look gathered as soon as SDL sees it, and the per-tick input state for 3dsdl
+#ifndef INPUT_H
+#define INPUT_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "data_structures.h"
+
+// Mouse motion is summed up by an SDL event watch whenever events get pumped, independently of the event
+// loop, so the camera can take the newest orientation right before the frame uses it (late latching).
+typedef struct {
+    SDL_mutex* lock;
+    int dx;              // motion in pixels not applied to the camera yet
+    int dy;
+    Uint64 first_seen;   // performance counter when the oldest of it came in (0 = nothing pending)
+} Mouse_Look;
+
+// Buttons held (or clicked) during a tick
+enum {
+    INPUT_FORWARD = 1 << 0,  // W
+    INPUT_BACK = 1 << 1,     // S
+    INPUT_LEFT = 1 << 2,     // A
+    INPUT_RIGHT = 1 << 3,    // D
+    INPUT_JUMP = 1 << 4,     // space
+    INPUT_SPRINT = 1 << 5,   // left shift
+    INPUT_BREAK = 1 << 6,    // left click with the mouse captured
+    INPUT_PLACE = 1 << 7     // right click with the mouse captured
+};
+
+// Everything the simulation takes from the player in one tick, so a session can be recorded and replayed
+// (see replay.h)
+typedef struct {
+    float dt;           // seconds
+    uint16_t buttons;   // INPUT_* bits
+    int look_dx;        // mouse look taken after the event loop, in pixels
+    int look_dy;
+    int late_dx;        // mouse look late latched right before rendering
+    int late_dy;
+} Input_Tick;
+
+// Prototypes
+void mouse_look_init(Mouse_Look* look);
+void mouse_look_free(Mouse_Look* look);
+Uint64 mouse_look_take(Mouse_Look* look, int* dx, int* dy);
+void mouse_look_apply(Camera* camera, int dx, int dy);
+uint16_t input_buttons(const Uint8* keystate, bool break_requested, bool place_requested);
+
+#endif
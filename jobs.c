@@ -0,0 +1,143 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <SDL2/SDL.h>
+#include "jobs.h"
+#include "profiler.h"
+
+// A single shared pool: one batch runs at a time and jobs_parallel_for blocks until it is done.
+static struct {
+    SDL_Thread* threads[JOBS_MAX_THREADS];
+    int thread_count;
+    SDL_mutex* mutex;
+    SDL_cond* work_cond;
+    SDL_cond* done_cond;
+    Job_Func func;
+    void* userdata;
+    size_t count;
+    SDL_atomic_t next;
+    int active;
+    unsigned generation;
+    bool quit;
+} pool;
+
+// Claim and run items of the current batch until none are left
+static void run_items(Job_Func func, void* userdata, size_t count, int worker) {
+    for (;;) {
+        size_t index = (size_t)SDL_AtomicAdd(&pool.next, 1);
+        if (index >= count) {
+            return;
+        }
+        func(userdata, index, worker);
+    }
+}
+
+static int job_worker(void* data) {
+    int worker = (int)(intptr_t)data;
+    unsigned seen = 0;
+    char name[32];
+    snprintf(name, sizeof(name), "worker %d", worker);
+    profiler_set_thread_name(name);
+    SDL_LockMutex(pool.mutex);
+    for (;;) {
+        while (!pool.quit && pool.generation == seen) {
+            SDL_CondWait(pool.work_cond, pool.mutex);
+        }
+        if (pool.quit) {
+            break;
+        }
+        seen = pool.generation;
+        Job_Func func = pool.func;
+        void* userdata = pool.userdata;
+        size_t count = pool.count;
+        SDL_UnlockMutex(pool.mutex);
+
+        run_items(func, userdata, count, worker);
+
+        SDL_LockMutex(pool.mutex);
+        if (--pool.active == 0) {
+            SDL_CondSignal(pool.done_cond);
+        }
+    }
+    SDL_UnlockMutex(pool.mutex);
+    return 0;
+}
+
+// Start the pool with the given number of worker threads (<= 0 means one per extra CPU core)
+void jobs_init(int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = SDL_GetCPUCount() - 1;
+    }
+    if (thread_count > JOBS_MAX_THREADS) {
+        thread_count = JOBS_MAX_THREADS;
+    }
+    pool.mutex = SDL_CreateMutex();
+    pool.work_cond = SDL_CreateCond();
+    pool.done_cond = SDL_CreateCond();
+    pool.thread_count = 0;
+    pool.generation = 0;
+    pool.quit = false;
+    for (int i = 0; i < thread_count; ++i) {
+        SDL_Thread* thread = SDL_CreateThread(job_worker, "3dsdl worker", (void*)(intptr_t)(i + 1));
+        if (!thread) {
+            printf("jobs_init(): SDL_CreateThread Error: %s\n", SDL_GetError());
+            break;
+        }
+        pool.threads[pool.thread_count++] = thread;
+    }
+}
+
+// Stop and join all worker threads
+void jobs_shutdown(void) {
+    if (!pool.mutex) {
+        return;
+    }
+    SDL_LockMutex(pool.mutex);
+    pool.quit = true;
+    SDL_CondBroadcast(pool.work_cond);
+    SDL_UnlockMutex(pool.mutex);
+    for (int i = 0; i < pool.thread_count; ++i) {
+        SDL_WaitThread(pool.threads[i], NULL);
+    }
+    SDL_DestroyCond(pool.done_cond);
+    SDL_DestroyCond(pool.work_cond);
+    SDL_DestroyMutex(pool.mutex);
+    pool.thread_count = 0;
+    pool.mutex = NULL;
+}
+
+// Number of pool threads (not counting the caller)
+int jobs_thread_count(void) {
+    return pool.thread_count;
+}
+
+// Run func(userdata, i, worker) for every i in [0, count) across the pool and the calling thread
+void jobs_parallel_for(size_t count, Job_Func func, void* userdata) {
+    if (count == 0 || !func) {
+        return;
+    }
+    if (pool.thread_count == 0 || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(userdata, i, 0);
+        }
+        return;
+    }
+
+    SDL_LockMutex(pool.mutex);
+    pool.func = func;
+    pool.userdata = userdata;
+    pool.count = count;
+    SDL_AtomicSet(&pool.next, 0);
+    pool.active = pool.thread_count;
+    pool.generation++;
+    SDL_CondBroadcast(pool.work_cond);
+    SDL_UnlockMutex(pool.mutex);
+
+    run_items(func, userdata, count, 0);
+
+    SDL_LockMutex(pool.mutex);
+    while (pool.active > 0) {
+        SDL_CondWait(pool.done_cond, pool.mutex);
+    }
+    SDL_UnlockMutex(pool.mutex);
+}
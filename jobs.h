@@ -0,0 +1,19 @@
+// jobs.h - small worker thread pool for data-parallel loops in 3dsdl
+#ifndef JOBS_H
+#define JOBS_H
+#include <stddef.h>
+
+// Upper bound on worker threads (the calling thread always helps too)
+#define JOBS_MAX_THREADS 31
+
+// Work item callback: `worker` is 0 for the calling thread and 1..jobs_thread_count() for pool threads,
+// so callers can keep per-thread scratch data without locking.
+typedef void (*Job_Func)(void* userdata, size_t index, int worker);
+
+// Prototypes
+void jobs_init(int thread_count);
+void jobs_shutdown(void);
+int jobs_thread_count(void);
+void jobs_parallel_for(size_t count, Job_Func func, void* userdata);
+
+#endif
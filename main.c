@@ -1,12 +1,31 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <float.h>
 #include <SDL2/SDL.h>
+#include "arena.h"
+#include "bench.h"
 #include "data_structures.h"
+#include "dynres.h"
 #include "imgui_overlay.h"
+#include "input.h"
+#include "jobs.h"
+#include "options.h"
+#include "pacing.h"
+#include "profiler.h"
+#include "raster.h"
+#include "raycast.h"
+#include "region.h"
+#include "replay.h"
+#include "retained.h"
 #include "rendering.h"
 #include "settings.h"
+#include "streaming.h"
+#include "terrain.h"
+#include "trace.h"
+#include "world.h"
 
 #include <math.h>
 #ifndef M_PI
@@ -26,37 +45,124 @@ Camera camera = {
 // Globals for SDL
 SDL_Renderer* renderer = NULL;
 static SDL_Window* window = NULL;
+static SDL_Surface* headless_target = NULL; // what the software renderer draws into in headless mode
 
 // Function prototypes
-bool init();
-void create_ground_grid(Cube_Map* map, int size, int x, int y, int z, SDL_Color color, int hole_size);
+bool init(const Options* options);
+void create_ground_grid(World* world, int size, int x, int y, int z, SDL_Color color, int hole_size);
+
+// Where streamed chunks come from with --world: the saved regions, then the terrain (if seeded)
+typedef struct {
+    Region_Store* store;
+    const Options* options;
+} World_Source;
+
+static bool world_chunk_source(void* userdata, Cube_Key key, Chunk_Data* out) {
+    World_Source* source = (World_Source*)userdata;
+    if (region_store_load_chunk(source->store, key, out)) {
+        return true;
+    }
+    if (source->options->use_terrain) {
+        return terrain_chunk_source((void*)&source->options->seed, key, out);
+    }
+    return false;
+}
+
+// Distance from the eye to the nearest point of a chunk (0 inside it)
+static float chunk_distance(const World* world, const Chunk* chunk, Point_3D eye) {
+    Point_3D first = world_cell_center(world, (Cube_Key){ .x = chunk->key.x * CHUNK_SIZE, .y = chunk->key.y * CHUNK_SIZE, .z = chunk->key.z * CHUNK_SIZE });
+    float lo = -world->step * 0.5f;
+    float hi = lo + world->step * (float)CHUNK_SIZE;
+    float dx = fmaxf(fmaxf(first.x + lo - eye.x, eye.x - (first.x + hi)), 0.0f);
+    float dy = fmaxf(fmaxf(first.y + lo - eye.y, eye.y - (first.y + hi)), 0.0f);
+    float dz = fmaxf(fmaxf(first.z + lo - eye.z, eye.z - (first.z + hi)), 0.0f);
+    return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+// Level of detail to draw a chunk at, from the on-screen size of its cubes at the chunk's nearest point (see
+// LOD_CUBE_PIXELS). The chosen level is kept in the chunk, since it only moves once the size is LOD_HYSTERESIS
+// past a threshold.
+static int select_chunk_lod(const World* world, Chunk* chunk, float distance, float focal_length) {
+    if (distance <= 0.0f) {
+        chunk->lod = 0;
+        return 0;
+    }
+    float cube_pixels = world->step * focal_length * (float)HEIGHT * 0.5f / distance;
+    int level = chunk->lod;
+    while (level + 1 < CHUNK_LOD_LEVELS && cube_pixels * (float)(1 << level) < LOD_CUBE_PIXELS * (1.0f - LOD_HYSTERESIS)) {
+        level++;
+    }
+    while (level > 0 && cube_pixels * (float)(1 << (level - 1)) > LOD_CUBE_PIXELS * (1.0f + LOD_HYSTERESIS)) {
+        level--;
+    }
+    chunk->lod = level;
+    return level;
+}
 
 // Main function
 int main(int argc, char** argv) {
-    // Avoid -Wunused-parameter warnings
-    (void)argc;
-    (void)argv;
+    Options options;
+    if (!parse_options(argc, argv, &options)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
 
     // Initialize SDL
-    if (!init()) {
+    if (!init(&options)) {
         fprintf(stderr, "Failed to initialize SDL. Exiting!\n");
         return EXIT_FAILURE;
     }
 
-    // Initialize a hashmap for cubes
-    Cube_Map cubes;
-    init_cube_map(&cubes, 2048);
-    
     // Ground grid parameters (just as an example until maps start being used)
     const int GROUND_SIZE = 9;
     const float GRID_OFFSET_X = ((GROUND_SIZE - 1) * CUBE_SIZE) / 2.0f;
     const float GRID_OFFSET_Z = ((GROUND_SIZE - 1) * CUBE_SIZE) / 2.0f;
     const float GRID_OFFSET_Y = CUBE_SIZE * 0.5f;
-    create_ground_grid(&cubes, GROUND_SIZE, 0, 0, 0, (SDL_Color){255, 255, 0, 255}, 0); // Yellow
-    create_ground_grid(&cubes, GROUND_SIZE, 0, 2, GROUND_SIZE, (SDL_Color){0, 255, 0, 255}, 1); // Green
-    create_ground_grid(&cubes, GROUND_SIZE, GROUND_SIZE, 4, GROUND_SIZE, (SDL_Color){0, 255, 255, 255}, 3); // Cyan
-    create_ground_grid(&cubes, GROUND_SIZE, GROUND_SIZE, 6, 0, (SDL_Color){255, 0, 255, 255}, 5); // Magenta
-    create_ground_grid(&cubes, GROUND_SIZE, 0, 8, 0, (SDL_Color){255, 255, 255, 255}, 7); // White
+
+    // Initialize the world (hashmap for cubes + chunk bookkeeping)
+    World world;
+    init_world(&world, 2048, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z);
+    profiler_set_thread_name("main");
+    jobs_init(options.threads);
+
+    // Where the player (re)spawns
+    Point_3D spawn = { .x = 0.0f, .y = 50.0f, .z = 0.0f };
+    Streamer streamer = {0};
+    Region_Store store = {0};
+    World_Source world_source = { .store = &store, .options = &options };
+    bool new_world = false;
+    if (options.world_dir) {
+        if (!region_store_open(&store, options.world_dir)) {
+            printf("main(): could not open world directory %s. Exiting!\n", options.world_dir);
+            exit(EXIT_FAILURE);
+        }
+        // A new world without a seed starts out as the example grids, a few rows of empty chunks around the
+        // terrain band give room to build in either case
+        new_world = !region_store_has_data(&store);
+        streamer_init(&streamer, options.terrain_radius, TERRAIN_BOTTOM / CHUNK_SIZE - 1, TERRAIN_TOP / CHUNK_SIZE + 2, world_chunk_source, &world_source);
+        streamer_set_sink(&streamer, region_store_sink, &store);
+    }
+    if (options.use_terrain) {
+        if (options.world_dir) {
+            // Already streaming from the saved world
+        } else if (options.stream) {
+            // Nothing is generated up front, chunks get streamed in around the player as the game runs
+            streamer_init(&streamer, options.terrain_radius, TERRAIN_BOTTOM / CHUNK_SIZE, TERRAIN_TOP / CHUNK_SIZE, terrain_chunk_source, &options.seed);
+        } else {
+            terrain_generate_area(&world, options.seed, options.terrain_radius);
+        }
+        // Drop in just above the terrain at the origin
+        Cube_Key top = { .x = world_to_grid_coord(0.0f, CUBE_SIZE, GRID_OFFSET_X), .y = 0, .z = world_to_grid_coord(0.0f, CUBE_SIZE, GRID_OFFSET_Z) };
+        top.y = terrain_surface_height(options.seed, top.x, top.z);
+        spawn.y = world_cell_center(&world, top).y + CUBE_SIZE * 0.5f + PLAYER_EYE_HEIGHT + 1.0f;
+        camera.y = spawn.y;
+    } else if (!options.world_dir || new_world) {
+        create_ground_grid(&world, GROUND_SIZE, 0, 0, 0, (SDL_Color){255, 255, 0, 255}, 0); // Yellow
+        create_ground_grid(&world, GROUND_SIZE, 0, 2, GROUND_SIZE, (SDL_Color){0, 255, 0, 255}, 1); // Green
+        create_ground_grid(&world, GROUND_SIZE, GROUND_SIZE, 4, GROUND_SIZE, (SDL_Color){0, 255, 255, 255}, 3); // Cyan
+        create_ground_grid(&world, GROUND_SIZE, GROUND_SIZE, 6, 0, (SDL_Color){255, 0, 255, 255}, 5); // Magenta
+        create_ground_grid(&world, GROUND_SIZE, 0, 8, 0, (SDL_Color){255, 255, 255, 255}, 7); // White
+    }
 
     // Camera parameters
     float fov_display = 60.0f;
@@ -65,8 +171,10 @@ int main(int argc, char** argv) {
 
     // Enable relative mouse mode for FPS-style look
     bool mouse_captured = true;
-    SDL_SetRelativeMouseMode(SDL_TRUE);
-    SDL_ShowCursor(SDL_DISABLE);
+    if (!options.headless) {
+        SDL_SetRelativeMouseMode(SDL_TRUE);
+        SDL_ShowCursor(SDL_DISABLE);
+    }
 
     // Vertical movement (jump / fall) parameters
     bool is_grounded = true;
@@ -77,28 +185,91 @@ int main(int argc, char** argv) {
     float walk_amp = 0.0f; // current amplitude, will smoothly approach WALK_AMPLITUDE when moving
     float walk_frequency_current = WALK_FREQUENCY; // may be increased while sprinting
 
-    // Buffers for rendering
-    Render_Face* faces = NULL;
-    size_t faces_cap = 0;
-    SDL_Vertex* tri_verts = NULL;
-    size_t tri_cap = 0;
-    static const int FACE_INDICES[6][4] = {
-        {0, 1, 2, 3},
-        {4, 5, 6, 7},
-        {0, 1, 5, 4},
-        {2, 3, 7, 6},
-        {1, 2, 6, 5},
-        {0, 3, 7, 4}
-    };
+    // Render pipeline counters of the last frame, and the switches of the counters panel
+    Render_Counters counters = {0};
+    size_t arena_heap_allocs_seen = 0;
+    Render_Settings render_settings = { .backend = RENDER_BACKEND_SDL, .backface_culling = BACKFACE_CULLING, .ray_block = RAYCAST_BLOCK, .chunk_lod = CHUNK_LOD,
+                                       .view_distance = VIEW_DISTANCE, .fog = FOG,
+                                       .retained = RETAINED_FRAMES, .late_latch = LATE_LATCH };
+    if (options.raster) {
+        render_settings.backend = RENDER_BACKEND_RASTER;
+    } else if (options.raycast) {
+        render_settings.backend = RENDER_BACKEND_RAYCAST;
+    }
+    Software_Rasterizer raster = {0};
+    Raycast_Renderer raycaster = {0};
+
+    // Block edits requested this frame (applied once the crosshair target is known)
+    bool break_requested = false;
+    bool place_requested = false;
 
     // Main loop
     bool running = true;
     SDL_Event event;
-    Uint32 last_ticks = SDL_GetTicks();
+    int frame_count = 0;
+    Uint64 run_start = SDL_GetPerformanceCounter();
+
+    // Input recording, or replay (which runs to the end of the log unless --frames stops it sooner)
+    Input_Log input_log = {0};
+    if (options.record_path && !input_log_record(&input_log, options.record_path, &options)) {
+        exit(EXIT_FAILURE);
+    }
+    if (options.replay_path) {
+        if (!input_log_replay(&input_log, options.replay_path, &options)) {
+            exit(EXIT_FAILURE);
+        }
+        if (options.frames == 0) {
+            options.frames = (int)input_log.tick_count;
+        }
+    }
+
+    // Per-stage frame timings, recorded for --bench
+    double stage_ms[BENCH_STAGE_COUNT] = {0};
+    Bench_Recorder bench = {0};
+    if (options.bench) {
+        bench_init(&bench, (size_t)options.frames);
+    }
+    if (options.trace_path) {
+        trace_capture_start(options.trace_path, (float)options.trace_seconds);
+    }
+
+    // Frame pacing (headless and benchmark runs go as fast as they can)
+    Pacing_Mode pacing_mode = PACING_CAPPED;
+    if (options.headless || options.bench || options.fps <= 0.0) {
+        pacing_mode = PACING_UNCAPPED;
+    } else if (options.vsync) {
+        pacing_mode = PACING_VSYNC;
+    }
+    Frame_Pacer pacer;
+    pacer_init(&pacer, pacing_mode, options.fps, PACING_SPIN_MS);
+    Window_State window_state = { .focused = true, .visible = true };
+
+    // Last world image, reused while nothing in view changes
+    Retained_Frame retained = {0};
+
+    // Mouse look gathered off the event queue, latched as late as the frame allows
+    Mouse_Look mouse_look;
+    mouse_look_init(&mouse_look);
+    float input_latency_ms = 0.0f; // of the last frame that had mouse look
+
+    // Dynamic resolution, budgeted on the frame cap
+    Dynamic_Resolution dynres = {0};
+    if (options.dynres && !dynres_init(&dynres, renderer, 1000.0 / (options.fps > 0.0 ? options.fps : TARGET_FPS))) {
+        options.dynres = false;
+    }
     while (running) {
-        Uint32 frame_start = SDL_GetTicks();
+        // Wait out the rest of the last frame before sampling input, so the input is as fresh as it can be when
+        // the frame gets built
+        PROFILE_BEGIN("frame cap");
+        pacer_wait(&pacer);
+        PROFILE_END();
+
+        Uint64 frame_counter_start = SDL_GetPerformanceCounter();
+        profiler_begin_frame();
+        trace_capture_frame();
 
         // Event handling
+        PROFILE_BEGIN("events");
         while (SDL_PollEvent(&event)) {
                 // Give ImGui a chance to handle events first
                 overlay_process_event(&event);
@@ -107,6 +278,21 @@ int main(int argc, char** argv) {
                     // Alt+F4 or clicking X button on window
                     running = false;
                     break;
+                case SDL_WINDOWEVENT:
+                    // In the background the frame cap drops to UNFOCUSED_FPS, and minimized nothing is drawn
+                    if (window_state_event(&window_state, &event.window) && window_state.visible) {
+                        if (window_state.focused) {
+                            pacer_init(&pacer, pacing_mode, options.fps, PACING_SPIN_MS);
+                        } else {
+                            pacer_init(&pacer, PACING_CAPPED, window_frame_rate(&window_state, options.fps), PACING_SPIN_MS);
+                        }
+                    }
+                    break;
+                case SDL_RENDER_TARGETS_RESET:
+                case SDL_RENDER_DEVICE_RESET:
+                    // The retained image is gone with the render targets
+                    retained_invalidate(&retained);
+                    break;
                 case SDL_KEYDOWN: {
                     // Toggle mouse capture with Esc key
                     if (event.key.keysym.sym == SDLK_ESCAPE) {
@@ -114,23 +300,31 @@ int main(int argc, char** argv) {
                         SDL_SetRelativeMouseMode(mouse_captured ? SDL_TRUE : SDL_FALSE);
                         SDL_ShowCursor(mouse_captured ? SDL_DISABLE : SDL_ENABLE);
                     }
-                    break;
-                }
-                case SDL_MOUSEMOTION: {
-                    // Update camera orientation from mouse movement
-                    camera.yaw += event.motion.xrel * MOUSE_SENSITIVITY;
-                    if (camera.yaw > 360.0f) {
-                        camera.yaw -= 360.0f;
-                    } else if (camera.yaw < 0.0f) {
-                        camera.yaw += 360.0f;
+                    // F2 shows the render counters, F3 the profiler
+                    if (event.key.keysym.sym == SDLK_F2) {
+                        overlay_toggle_counters();
                     }
-                    // Standard Y (not inverted)
-                    camera.pitch += event.motion.yrel * MOUSE_SENSITIVITY;
-                    if (camera.pitch > PITCH_MAX) {
-                        camera.pitch = PITCH_MAX;
+                    if (event.key.keysym.sym == SDLK_F3) {
+                        overlay_toggle_profiler();
                     }
-                    if (camera.pitch < PITCH_MIN) {
-                        camera.pitch = PITCH_MIN;
+                    // F4 captures a trace of the next few seconds
+                    if (event.key.keysym.sym == SDLK_F4 && !trace_capture_active()) {
+                        char trace_path[64];
+                        snprintf(trace_path, sizeof(trace_path), "trace_%ld.json", (long)time(NULL));
+                        trace_capture_start(trace_path, (float)options.trace_seconds);
+                    }
+                    // F5 saves the edited chunks of a --world
+                    if (event.key.keysym.sym == SDLK_F5 && options.world_dir) {
+                        printf("Saved %zu chunks to %s\n", region_store_save_world(&store, &world), options.world_dir);
+                    }
+                    break;
+                }
+                case SDL_MOUSEBUTTONDOWN: {
+                    // Left click breaks the targeted block, right click places one against the targeted face
+                    if (mouse_captured && event.button.button == SDL_BUTTON_LEFT) {
+                        break_requested = true;
+                    } else if (mouse_captured && event.button.button == SDL_BUTTON_RIGHT) {
+                        place_requested = true;
                     }
                     break;
                 }
@@ -138,15 +332,57 @@ int main(int argc, char** argv) {
                     break;
             }
         }
+        PROFILE_END();
+
+        // Mouse look gathered by the event watch (see input.h)
+        int look_dx = 0;
+        int look_dy = 0;
+        Uint64 input_time = mouse_look_take(&mouse_look, &look_dx, &look_dy);
 
         // Calculate delta time for this frame
-        Uint32 now = SDL_GetTicks();
-        float dt = (now - last_ticks) / 1000.0f; // delta time in seconds
-        last_ticks = now;
+        float dt = (float)pacer_delta(&pacer); // delta time in seconds
+        if (options.headless || options.bench) {
+            dt = 1.0f / TARGET_FPS; // fixed steps, so a headless run simulates the same thing on any machine
+        }
+
+        // Minimized or hidden without --hidden-hz: the simulation pauses, and the loop sleeps in the event queue
+        // until the window is back
+        if (!window_state.visible && options.hidden_hz <= 0.0) {
+            SDL_WaitEventTimeout(NULL, HIDDEN_WAIT_MS);
+            continue;
+        }
+
+        // This tick's input, from the player or the next tick of the --replay log. Everything the simulation
+        // below takes from the player comes from here, so replaying it repeats the session exactly.
+        Input_Tick tick = {
+            .dt = dt,
+            .buttons = input_buttons(SDL_GetKeyboardState(NULL), break_requested, place_requested),
+            .look_dx = look_dx,
+            .look_dy = look_dy
+        };
+        if (options.replay_path) {
+            if (!input_log_read(&input_log, &tick)) {
+                printf("Replay finished after %zu ticks\n", input_log.tick);
+                running = false;
+                continue;
+            }
+            dt = tick.dt;
+            input_time = 0;
+        }
+        mouse_look_apply(&camera, tick.look_dx, tick.look_dy);
+        break_requested = (tick.buttons & INPUT_BREAK) != 0;
+        place_requested = (tick.buttons & INPUT_PLACE) != 0;
+
+        // Bring streamed chunks in (and old ones out) before anything looks at the world this frame
+        if (options.stream) {
+            PROFILE_BEGIN("stream");
+            streamer_update(&streamer, &world, (Point_3D){camera.x, camera.y, camera.z});
+            PROFILE_END();
+        }
 
         // WASD controls move the camera relative to view (crosshair)
-        const Uint8* keystate = SDL_GetKeyboardState(NULL);
-        bool sprint = (keystate[SDL_SCANCODE_LSHIFT] && keystate[SDL_SCANCODE_W]);
+        PROFILE_BEGIN("update");
+        bool sprint = (tick.buttons & INPUT_SPRINT) && (tick.buttons & INPUT_FORWARD);
         float move_speed = BASE_SPEED * (sprint ? SPRINT_MULT : 1.0f);
         walk_frequency_current = sprint ? (WALK_FREQUENCY * 1.4f) : WALK_FREQUENCY;
         float fov_target = sprint ? SPRINT_FOV : FOV;
@@ -179,37 +415,50 @@ int main(int argc, char** argv) {
         float glen = sqrtf(gx*gx + gz*gz);
         if (glen > 0.000001f) { gx /= glen; gz /= glen; } else { gx = 0.0f; gz = 1.0f; }
 
-        if (keystate[SDL_SCANCODE_W]) {
+        if (tick.buttons & INPUT_FORWARD) {
             wish_vx += gx * move_speed;
             wish_vz += gz * move_speed;
         }
-        if (keystate[SDL_SCANCODE_S]) {
+        if (tick.buttons & INPUT_BACK) {
             wish_vx -= gx * move_speed;
             wish_vz -= gz * move_speed;
         }
-        if (keystate[SDL_SCANCODE_A]) {
+        if (tick.buttons & INPUT_LEFT) {
             wish_vx -= rx * move_speed;
             wish_vz -= rz * move_speed;
         }
-        if (keystate[SDL_SCANCODE_D]) {
+        if (tick.buttons & INPUT_RIGHT) {
             wish_vx += rx * move_speed;
             wish_vz += rz * move_speed;
         }
-        if (keystate[SDL_SCANCODE_SPACE] && is_grounded) {
+        if ((tick.buttons & INPUT_JUMP) && is_grounded) {
             vertical_velocity = JUMP_IMPULSE;
             is_grounded = false;
         }
 
+        // Hold the player in the air until the ground below has been streamed in
+        if (options.stream) {
+            Cube_Key feet = {
+                .x = world_to_grid_index_floor(camera.x, CUBE_SIZE, GRID_OFFSET_X),
+                .y = world_to_grid_index_floor(camera.y - PLAYER_EYE_HEIGHT, CUBE_SIZE, GRID_OFFSET_Y),
+                .z = world_to_grid_index_floor(camera.z, CUBE_SIZE, GRID_OFFSET_Z)
+            };
+            if (!streamer_column_resident(&streamer, world_chunk_key(feet))) {
+                vertical_velocity = 0.0f;
+                is_grounded = true;
+            }
+        }
+
         // Resolve horizontal movement with collisions (axis-by-axis)
         float new_x = camera.x + wish_vx * dt;
         AABB box_x = player_aabb(new_x, camera.y, camera.z, PLAYER_RADIUS, PLAYER_HEIGHT, PLAYER_EYE_HEIGHT);
-        if (!aabb_intersects_map(&cubes, box_x, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z)) {
+        if (!aabb_intersects_map(&world.cubes, box_x, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z)) {
             camera.x = new_x;
         }
 
         float new_z = camera.z + wish_vz * dt;
         AABB box_z = player_aabb(camera.x, camera.y, new_z, PLAYER_RADIUS, PLAYER_HEIGHT, PLAYER_EYE_HEIGHT);
-        if (!aabb_intersects_map(&cubes, box_z, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z)) {
+        if (!aabb_intersects_map(&world.cubes, box_z, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z)) {
             camera.z = new_z;
         }
 
@@ -222,7 +471,7 @@ int main(int argc, char** argv) {
 
         float new_y = camera.y + vertical_velocity * dt;
         AABB box_y = player_aabb(camera.x, new_y, camera.z, PLAYER_RADIUS, PLAYER_HEIGHT, PLAYER_EYE_HEIGHT);
-        if (aabb_intersects_map(&cubes, box_y, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z)) {
+        if (aabb_intersects_map(&world.cubes, box_y, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z)) {
             // Collide vertically
             if (vertical_velocity < 0.0f) {
                 is_grounded = true;
@@ -233,7 +482,7 @@ int main(int argc, char** argv) {
             camera.y = new_y;
             if (vertical_velocity <= 0.0f) {
                 AABB probe = player_aabb(camera.x, camera.y - GROUND_EPS, camera.z, PLAYER_RADIUS, PLAYER_HEIGHT, PLAYER_EYE_HEIGHT);
-                is_grounded = aabb_intersects_map(&cubes, probe, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z);
+                is_grounded = aabb_intersects_map(&world.cubes, probe, CUBE_SIZE, GRID_OFFSET_X, GRID_OFFSET_Y, GRID_OFFSET_Z);
                 if (is_grounded) {
                     vertical_velocity = 0.0f;
                 }
@@ -244,17 +493,28 @@ int main(int argc, char** argv) {
 
         // Simple fall reset if we drop too far below the world
         if (camera.y < -FALL_RESET_DISTANCE) {
-            camera.x = 0.0f;
-            camera.y = 50.0f;
-            camera.z = 0.0f;
+            camera.x = spawn.x;
+            camera.y = spawn.y;
+            camera.z = spawn.z;
             camera.yaw = 0.0f;
             camera.pitch = 45.0f;
             vertical_velocity = 0.0f;
             is_grounded = false;
         }
 
+        // Benchmark runs ignore the player and fly the scripted camera path instead (unless they replay a session)
+        if (options.bench && !options.replay_path) {
+            Point_3D position;
+            bench_camera_path((float)frame_count / (float)options.frames, spawn, &position, &camera.yaw, &camera.pitch);
+            camera.x = position.x;
+            camera.y = position.y;
+            camera.z = position.z;
+            vertical_velocity = 0.0f;
+            is_grounded = true;
+        }
+
         // Walking bob calculation for smooth start/stop (only when on ground and not jumping or falling)
-        bool moving_input = (keystate[SDL_SCANCODE_W] || keystate[SDL_SCANCODE_A] || keystate[SDL_SCANCODE_S] || keystate[SDL_SCANCODE_D]);
+        bool moving_input = (tick.buttons & (INPUT_FORWARD | INPUT_LEFT | INPUT_BACK | INPUT_RIGHT)) != 0;
         float target_amp = (is_grounded && moving_input) ? WALK_AMPLITUDE : 0.0f;
         walk_amp += (target_amp - walk_amp) * fminf(1.0f, dt * WALK_SMOOTH); // smooth amplitude
         if (walk_amp > 0.0001f) {
@@ -265,57 +525,236 @@ int main(int argc, char** argv) {
         // apply bob to camera for this frame only (don't modify permanent camera_pos when jumping)
         float saved_camera_y = camera.y;
         camera.y += bob_offset;
+        PROFILE_END();
 
-        // Clear screen
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_RenderClear(renderer);
+        // Pick the block under the crosshair (the view ray goes through the center of the screen)
+        PROFILE_BEGIN("pick");
+        Ray_Hit target = {0};
+        world_raycast(&world, (Point_3D){camera.x, camera.y, camera.z}, (Point_3D){fx, fy, fz}, PICK_DISTANCE, &target);
 
-        // Build and draw all cube faces using Painter's Sorting
-        // TODO: Backface culling to skip faces that are facing away from the camera
-        size_t max_faces = cubes.size * 6;
-        if (max_faces > faces_cap) {
-            faces_cap = max_faces;
-            faces = (Render_Face*)realloc(faces, faces_cap * sizeof(Render_Face));
+        // Apply block edits before building faces, so the change shows up in this very frame.
+        // Only the chunks touching the edited cell get their meshes rebuilt.
+        if (break_requested && target.hit) {
+            world_remove_cube(&world, target.key);
+            target.hit = false;
+        } else if (place_requested && target.hit) {
+            Cube_Key place_key = {
+                .x = target.key.x + target.normal_x,
+                .y = target.key.y + target.normal_y,
+                .z = target.key.z + target.normal_z
+            };
+            AABB player_box = player_aabb(camera.x, saved_camera_y, camera.z, PLAYER_RADIUS, PLAYER_HEIGHT, PLAYER_EYE_HEIGHT);
+            const Cube* target_cube = world_get_cube(&world, target.key);
+            if (target_cube && !world_get_cube(&world, place_key) && !aabb_overlaps(player_box, world_cell_aabb(&world, place_key))) {
+                world_place_cube(&world, place_key, target_cube->color);
+            }
         }
-        size_t face_count = 0;
+        break_requested = false;
+        place_requested = false;
+        PROFILE_END();
 
-        size_t cubes_capacity = cube_map_capacity(&cubes);
-        for (size_t ci = 0; ci < cubes_capacity; ++ci) {
-            const Cube_Map_Entry* entry = cube_map_entry_at(&cubes, ci);
-            if (!entry || !entry->occupied || !entry->cube) {
-                continue;
+        // Late latch: motion that came in during the simulation turns the camera right before it's rendered,
+        // so it's on screen a frame sooner. Movement and picking keep the orientation they were done with.
+        if (options.replay_path) {
+            mouse_look_apply(&camera, tick.late_dx, tick.late_dy);
+        } else if (render_settings.late_latch && !options.bench) {
+            Uint64 late_time = mouse_look_take(&mouse_look, &tick.late_dx, &tick.late_dy);
+            mouse_look_apply(&camera, tick.late_dx, tick.late_dy);
+            if (input_time == 0) {
+                input_time = late_time;
+            }
+        }
+        if (options.record_path && input_log.file) {
+            input_log_write(&input_log, &tick);
+        }
+
+        // Minimized or hidden with --hidden-hz: the simulation went on, but there's nothing to draw, so sleep in
+        // the event queue until the next tick
+        if (!window_state.visible) {
+            frame_arenas_reset();
+            camera.y = saved_camera_y;
+            SDL_WaitEventTimeout(NULL, (int)(1000.0 / options.hidden_hz));
+            continue;
+        }
+
+        // Retained frames: while the camera, the world and the render settings stay the same, the last world
+        // image is copied to the screen again and the whole pipeline below is skipped
+        Render_Key render_key = {
+            .camera = camera,
+            .world_revision = world.revision,
+            .settings = render_settings,
+            .render_scale = options.dynres ? dynres.scale : 1.0f
+        };
+        bool retain = render_settings.retained && !options.headless && !options.bench;
+        if (retain && !options.dynres && !retained.target && !retained_init(&retained, renderer)) {
+            render_settings.retained = false;
+            retain = false;
+        }
+        if (!retain) {
+            retained_invalidate(&retained);
+        }
+        bool reuse = retain && retained_match(&retained, &render_key);
+
+        // Draw into the scaled render target with dynamic resolution, or into the retained image
+        if (options.dynres) {
+            dynres_begin(&dynres, renderer);
+        } else if (retain) {
+            retained_begin(&retained, renderer);
+        }
+        Uint64 lap = SDL_GetPerformanceCounter();
+        size_t line_calls_before = draw_line_calls();
+        if (!reuse) {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+            SDL_RenderClear(renderer);
+
+            // Rebuild the cached meshes of chunks touched by edits, and count the faces to draw (at whichever
+            // level of detail has the most)
+            PROFILE_BEGIN("mesh");
+            world_mesh_dirty_chunks(&world);
+            size_t chunks_capacity = chunk_map_capacity(&world.chunks);
+            size_t max_faces = 0;
+            for (size_t ci = 0; ci < chunks_capacity; ++ci) {
+                const Chunk_Map_Entry* entry = chunk_map_entry_at(&world.chunks, ci);
+                if (entry && entry->occupied && entry->chunk) {
+                    size_t most = 0;
+                    for (int level = 0; level < CHUNK_LOD_LEVELS; ++level) {
+                        size_t count = 0;
+                        world_chunk_mesh(entry->chunk, level, &count);
+                        most = count > most ? count : most;
+                    }
+                    max_faces += most;
+                }
+            }
+            PROFILE_END();
+
+            // Build and draw all visible cube faces, using Painter's Sorting or the software rasterizer's z-buffer
+            // (the ray caster skips the faces and reads the grid directly). The face buffers (like all transient
+            // frame data) come from the frame arena, which is reset at the end of the frame.
+            Arena* arena = frame_arena(0);
+            float render_scale = options.dynres ? dynres.scale : 1.0f;
+            if (render_settings.backend == RENDER_BACKEND_RASTER && !raster.texture && !raster_init(&raster, renderer)) {
+                render_settings.backend = RENDER_BACKEND_SDL;
+            }
+            if (render_settings.backend == RENDER_BACKEND_RAYCAST && !raycaster.texture && !raycast_init(&raycaster, renderer)) {
+                render_settings.backend = RENDER_BACKEND_SDL;
+            }
+            bool raster_backend = render_settings.backend == RENDER_BACKEND_RASTER;
+            bool raycast_backend = render_settings.backend == RENDER_BACKEND_RAYCAST;
+            size_t mesh_chunks = chunks_capacity;
+            if (raycast_backend) {
+                mesh_chunks = 0;
+                max_faces = 0;
+            }
+            View_Face* view_faces = ARENA_ALLOC_ARRAY(arena, View_Face, max_faces);
+            Render_Face* faces = NULL;
+            if (raster_backend) {
+                raster_begin(&raster, arena, max_faces, render_scale);
+            } else {
+                faces = ARENA_ALLOC_ARRAY(arena, Render_Face, max_faces);
             }
+            size_t face_count = 0;
+            lap = SDL_GetPerformanceCounter();
+            memset(&counters, 0, sizeof(counters));
 
-            Camera_Point cam_pts[8] = {0};
-            compute_camera_points(entry->cube, cam_pts);
+            // Transform stage: every chunk mesh face facing the camera into camera space (backface culling is
+            // a plane test against the eye in world space, before paying for the transform). Chunks beyond the
+            // view distance are skipped whole, far chunks use a coarser mesh, and far faces lose their outlines
+            // and fade into the fog.
+            PROFILE_BEGIN("transform");
+            Camera_Basis basis = compute_camera_basis();
+            Point_3D eye = { camera.x, camera.y, camera.z };
+            const float view_distance = render_settings.view_distance;
+            const float fog_start = view_distance * FOG_START;
+            size_t view_face_count = 0;
+            for (size_t ci = 0; ci < mesh_chunks; ++ci) {
+                const Chunk_Map_Entry* entry = chunk_map_entry_at(&world.chunks, ci);
+                if (!entry || !entry->occupied || !entry->chunk) {
+                    continue;
+                }
+                Chunk* chunk = entry->chunk;
+                float distance = chunk_distance(&world, chunk, eye);
+                if (distance > view_distance) {
+                    counters.chunks_distance++;
+                    continue;
+                }
+                bool fogged = render_settings.fog && distance + world.step * (float)CHUNK_SIZE * 1.7320508f > fog_start;
+                int level = render_settings.chunk_lod ? select_chunk_lod(&world, chunk, distance, camera.focal_length) : 0;
+                size_t mesh_face_count = 0;
+                const Chunk_Face* mesh_faces = world_chunk_mesh(chunk, level, &mesh_face_count);
+                counters.chunks_visited++;
+                counters.chunks_lod_2x += level == 1 ? 1 : 0;
+                counters.chunks_lod_4x += level == 2 ? 1 : 0;
+                counters.cubes_visited += chunk->cube_count;
+                counters.faces_generated += mesh_face_count;
 
-            for (size_t fi = 0; fi < 6; ++fi) {
-                int i0 = FACE_INDICES[fi][0];
-                int i1 = FACE_INDICES[fi][1];
-                int i2 = FACE_INDICES[fi][2];
-                int i3 = FACE_INDICES[fi][3];
+                for (size_t fi = 0; fi < mesh_face_count; ++fi) {
+                    const Chunk_Face* mesh_face = &mesh_faces[fi];
+                    if (render_settings.backface_culling && !world_face_visible(mesh_face, eye)) {
+                        counters.faces_backface++;
+                        continue;
+                    }
+                    float face_distance = 0.0f;
+                    if (fogged) {
+                        const Point_3D* p = mesh_face->points;
+                        float cx = (p[0].x + p[2].x) * 0.5f - eye.x;
+                        float cy = (p[0].y + p[2].y) * 0.5f - eye.y;
+                        float cz = (p[0].z + p[2].z) * 0.5f - eye.z;
+                        face_distance = sqrtf(cx * cx + cy * cy + cz * cz);
+                        if (face_distance >= view_distance) {
+                            counters.faces_fogged++;
+                            continue;
+                        }
+                    }
+                    View_Face* view_face = &view_faces[view_face_count++];
+                    float nearest = FLT_MAX;
+                    for (int pi = 0; pi < 4; ++pi) {
+                        view_face->points[pi] = transform_to_camera(&basis, mesh_face->points[pi]);
+                        nearest = fminf(nearest, view_face->points[pi].z);
+                        view_face->lit[pi] = fogged ? apply_fog(mesh_face->lit[pi], face_distance, fog_start, view_distance) : mesh_face->lit[pi];
+                    }
+                    view_face->color = fogged ? apply_fog(mesh_face->color, face_distance, fog_start, view_distance) : mesh_face->color;
+                    view_face->outline = nearest < OUTLINE_MAX_DISTANCE;
+                }
+            }
+            PROFILE_END();
+            stage_ms[BENCH_TRANSFORM] = bench_lap(&lap);
 
-                Camera_Point face_in[4] = {
-                    cam_pts[i0],
-                    cam_pts[i1],
-                    cam_pts[i2],
-                    cam_pts[i3]
-                };
+            // Clip stage: cull and clip against the frustum (with a guard band) in camera space, then project
+            // and build the render faces
+            PROFILE_BEGIN("clip");
+            for (size_t vi = 0; vi < view_face_count; ++vi) {
+                const View_Face* view_face = &view_faces[vi];
 
-                // Near-plane clipping: clip each face polygon to z >= z_near.
                 const float z_near = 0.05f;
-                Camera_Point clipped[6] = {0};
-                size_t clipped_count = clip_polygon_near(face_in, 4, z_near, clipped);
-                if (clipped_count < 3) {
+                Camera_Point clipped[MAX_CLIPPED_POINTS];
+                size_t clipped_count = 0;
+                Frustum_Result clip = clip_polygon_frustum(view_face->points, 4, z_near, clipped, &clipped_count);
+                if (clip == FRUSTUM_BEHIND) {
+                    counters.faces_near_clipped++;
+                    continue;
+                }
+                if (clip == FRUSTUM_OUTSIDE) {
+                    counters.faces_offscreen++;
                     continue;
                 }
+                counters.faces_clipped += clip == FRUSTUM_CLIPPED ? 1 : 0;
 
-                Projected_Point projected[6] = {0};
+                Projected_Point projected[MAX_CLIPPED_POINTS];
                 for (size_t pi = 0; pi < clipped_count; ++pi) {
                     projected[pi] = project_to_screen(&clipped[pi]);
                 }
 
-                if (polygon_completely_offscreen(projected, clipped_count)) {
+                // The baked corner colors, interpolated to the new corners of a clipped face
+                SDL_Color clipped_colors[MAX_CLIPPED_POINTS];
+                const SDL_Color* colors = view_face->lit;
+                if (clip == FRUSTUM_CLIPPED) {
+                    interpolate_quad_colors(view_face->points, view_face->lit, clipped, clipped_count, clipped_colors);
+                    colors = clipped_colors;
+                }
+
+                counters.faces_outlined += view_face->outline ? 1 : 0;
+                if (raster_backend) {
+                    raster_add_polygon(&raster, projected, clipped, colors, clipped_count, view_face->color, view_face->outline);
                     continue;
                 }
 
@@ -328,112 +767,205 @@ int main(int argc, char** argv) {
                 }
                 face->depth = depth_sum / (float)clipped_count;
 
-                SDL_Color c = entry->cube->color;
-                //SDL_Color c = (SDL_Color){ 0, 0, 0, 255 };
-                face->color = entry->cube->color;
-                c.a = 32;
+                face->color = view_face->color;
+                SDL_Color c[MAX_CLIPPED_POINTS];
+                for (size_t pi = 0; pi < clipped_count; ++pi) {
+                    c[pi] = colors[pi];
+                    c[pi].a = 32;
+                }
                 for (size_t tri = 1; tri + 1 < clipped_count; ++tri) {
                     size_t vbase = face->vert_count;
-                    face->verts[vbase + 0] = (SDL_Vertex){ .position = {projected[0].x, projected[0].y}, .color = c, .tex_coord = {0.0f, 0.0f} };
-                    face->verts[vbase + 1] = (SDL_Vertex){ .position = {projected[tri].x, projected[tri].y}, .color = c, .tex_coord = {0.0f, 0.0f} };
-                    face->verts[vbase + 2] = (SDL_Vertex){ .position = {projected[tri + 1].x, projected[tri + 1].y}, .color = c, .tex_coord = {0.0f, 0.0f} };
+                    face->verts[vbase + 0] = (SDL_Vertex){ .position = {projected[0].x, projected[0].y}, .color = c[0], .tex_coord = {0.0f, 0.0f} };
+                    face->verts[vbase + 1] = (SDL_Vertex){ .position = {projected[tri].x, projected[tri].y}, .color = c[tri], .tex_coord = {0.0f, 0.0f} };
+                    face->verts[vbase + 2] = (SDL_Vertex){ .position = {projected[tri + 1].x, projected[tri + 1].y}, .color = c[tri + 1], .tex_coord = {0.0f, 0.0f} };
                     face->vert_count += 3;
                 }
 
-                for (size_t pi = 0; pi < clipped_count && pi < 6; ++pi) {
+                for (size_t pi = 0; view_face->outline && pi < clipped_count; ++pi) {
                     face->line_pts[face->line_count++] = projected[pi];
                 }
             }
-        }
-
-        if (face_count > 1) {
-            qsort(faces, face_count, sizeof(Render_Face), compare_face_depth_desc);
-        }
 
-        size_t total_verts = 0;
-        for (size_t i = 0; i < face_count; ++i) {
-            total_verts += faces[i].vert_count;
-        }
+            PROFILE_END();
+            stage_ms[BENCH_CLIP] = bench_lap(&lap);
 
-        if (total_verts > tri_cap) {
-            tri_cap = total_verts;
-            tri_verts = (SDL_Vertex*)realloc(tri_verts, tri_cap * sizeof(SDL_Vertex));
-        }
-
-        size_t write_index = 0;
-        for (size_t i = 0; i < face_count; ++i) {
-            for (size_t v = 0; v < faces[i].vert_count; ++v) {
-                tri_verts[write_index++] = faces[i].verts[v];
+            PROFILE_BEGIN("sort");
+            if (face_count > 1) {
+                qsort(faces, face_count, sizeof(Render_Face), compare_face_depth_desc);
             }
-        }
+            PROFILE_END();
+            stage_ms[BENCH_SORT] = bench_lap(&lap);
+            counters.faces_drawn = raster_backend ? raster.polygon_count : face_count;
+            counters.sort_ms = (float)stage_ms[BENCH_SORT];
+            counters.faces_capacity = max_faces;
 
-        // Fill triangles in Painter's order (sorted by depth)
-        if (total_verts > 0) {
-            SDL_RenderGeometry(renderer, NULL, tri_verts, (int)total_verts, NULL, 0);
+            // Submit stage: fill and outline the faces in Painter's order
+            PROFILE_BEGIN("submit");
+            if (raycast_backend) {
+                counters.ray_hits = raycast_draw(&raycaster, renderer, arena, &world, &camera, render_scale, &render_settings);
+                counters.rays = (size_t)raycaster.width * (size_t)raycaster.height;
+            } else if (raster_backend) {
+                raster_draw(&raster, renderer, arena);
+                counters.triangles += raster.triangle_count;
+                counters.vertices += raster.triangle_count * 3;
+            } else {
+                submit_faces(faces, face_count, arena, &counters);
+            }
+            PROFILE_END();
         }
+        counters.frames_retained = reuse ? retained.reused : 0;
 
-        // Draw face outlines on top of filled faces for better visibility, also in Painter's order
-        for (size_t i = 0; i < face_count; ++i) {
-            Render_Face* face = &faces[i];
-            if (face->line_count < 2) {
-                continue;
-            }
-            SDL_SetRenderDrawColor(renderer, face->color.r, face->color.g, face->color.b, 255);
-            const int outline_thickness = 3;
-            for (size_t p = 0; p < face->line_count; ++p) {
-                size_t next = (p + 1) % face->line_count;
-                draw_line_thickness(
-                    (int)SDL_roundf(face->line_pts[p].x),
-                    (int)SDL_roundf(face->line_pts[p].y),
-                    (int)SDL_roundf(face->line_pts[next].x),
-                    (int)SDL_roundf(face->line_pts[next].y),
-                    outline_thickness);
-            }
+        // Stretch the scaled world over the window (or copy the retained image), everything from here on is
+        // drawn at native resolution
+        PROFILE_BEGIN("composite");
+        if (options.dynres) {
+            PROFILE_BEGIN("upscale");
+            dynres_end(&dynres, renderer);
+            PROFILE_END();
+        } else if (retain) {
+            retained_end(&retained, renderer);
         }
+        counters.render_scale = dynres.target ? dynres.scale * 100.0f : 100.0f;
 
         // Draw static crosshair in the center of the screen
         draw_crosshair(3, 17);
+        counters.line_calls = draw_line_calls() - line_calls_before;
+        PROFILE_END();
+        stage_ms[BENCH_SUBMIT] = bench_lap(&lap);
 
         // ImGui overlay: update stats, start a new frame, let it draw UI, then render on top
+        PROFILE_BEGIN("overlay");
         if (OVERLAY_ON) {
-            overlay_set_stats(camera.x, camera.y, camera.z, camera.yaw, camera.pitch, fov_display, cubes.size, cube_map_capacity(&cubes));
+            overlay_set_stats(camera.x, camera.y, camera.z, camera.yaw, camera.pitch, fov_display, world.cubes.size, cube_map_capacity(&world.cubes));
+            overlay_set_target(target.hit, target.key.x, target.key.y, target.key.z, target.distance);
+            if (options.stream) {
+                overlay_set_streaming(streamer.resident_count, streamer_in_flight(&streamer));
+            }
+            overlay_set_capturing(trace_capture_active());
+            size_t arena_heap_allocs = frame_arenas_heap_allocs();
+            counters.arena_bytes = frame_arenas_used();
+            counters.arena_high_water = frame_arenas_high_water();
+            counters.arena_heap_allocs = arena_heap_allocs - arena_heap_allocs_seen;
+            arena_heap_allocs_seen = arena_heap_allocs;
+            counters.input_latency_ms = input_latency_ms;
+            overlay_set_counters(&counters, &render_settings);
         }
         overlay_newframe();
         overlay_render();
+        PROFILE_END();
+        stage_ms[BENCH_OVERLAY] = bench_lap(&lap);
 
-        // Render present
+        // Render present. With vsync the present blocks on the display, so it isn't counted as frame work.
+        Uint64 work_end = SDL_GetPerformanceCounter();
+        PROFILE_BEGIN("present");
         SDL_RenderPresent(renderer);
+        PROFILE_END();
+        if (input_time != 0) {
+            input_latency_ms = (float)((double)(SDL_GetPerformanceCounter() - input_time) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+        }
+        stage_ms[BENCH_PRESENT] = bench_lap(&lap);
+        if (options.dynres) {
+            if (!options.vsync) {
+                work_end = SDL_GetPerformanceCounter();
+            }
+            dynres_update(&dynres, (double)(work_end - frame_counter_start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+        }
+        if (options.bench) {
+            bench_record(&bench, stage_ms, bench_lap(&frame_counter_start), counters.faces_drawn);
+        }
+        frame_arenas_reset();
 
         // restore camera Y after rendering
         camera.y = saved_camera_y;
 
-        // FPS capping
-        Uint32 frame_time = SDL_GetTicks() - frame_start;
-        if (frame_time < FRAME_DELAY) {
-            SDL_Delay(FRAME_DELAY - frame_time);
+        if (options.frames > 0 && ++frame_count >= options.frames) {
+            running = false;
+        }
+    }
+    if (options.headless) {
+        double seconds = (double)(SDL_GetPerformanceCounter() - run_start) / (double)SDL_GetPerformanceFrequency();
+        printf("Headless: %d frames in %.2f s (%.3f ms/frame, %.1f FPS)\n", frame_count, seconds, seconds * 1000.0 / frame_count, frame_count / seconds);
+    }
+
+    if (options.bench) {
+        char label[64];
+        if (options.use_terrain) {
+            snprintf(label, sizeof(label), "seed %u, radius %d", (unsigned)options.seed, options.terrain_radius);
+        } else {
+            snprintf(label, sizeof(label), "%s", options.world_dir ? "saved world" : "example grids");
         }
+        bench_write(&bench, options.bench_out, label);
+        bench_free(&bench);
     }
 
     // Cleanup
     // Shutdown ImGui overlay if present
     overlay_shutdown();
 
-    free(tri_verts);
-    free(faces);
+    frame_arenas_free();
+    dynres_free(&dynres);
+    input_log_close(&input_log);
+    mouse_look_free(&mouse_look);
+    if (retained.target) {
+        retained_free(&retained);
+    }
+    if (raster.texture) {
+        raster_free(&raster);
+    }
+    if (raycaster.texture) {
+        raycast_free(&raycaster);
+    }
+    if (options.stream) {
+        streamer_shutdown(&streamer);
+    }
+    if (options.world_dir) {
+        printf("Saved %zu chunks to %s\n", region_store_save_world(&store, &world), options.world_dir);
+        region_store_close(&store);
+    }
+    free_world(&world);
+    trace_shutdown();
+    jobs_shutdown();
 
     SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
+    if (headless_target) {
+        SDL_FreeSurface(headless_target);
+    }
     SDL_Quit();
     
     return EXIT_SUCCESS;
 }
 
-bool init() {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+bool init(const Options* options) {
+    if (SDL_Init(options->headless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO) != 0) {
         printf("SDL_Init Error: %s\n", SDL_GetError());
         return false;
     }
 
+    if (options->headless) {
+        // Software renderer drawing into an offscreen surface, no display needed
+        headless_target = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (!headless_target) {
+            printf("SDL_CreateRGBSurfaceWithFormat Error: %s\n", SDL_GetError());
+            SDL_Quit();
+            return false;
+        }
+        renderer = SDL_CreateSoftwareRenderer(headless_target);
+        if (!renderer) {
+            printf("SDL_CreateSoftwareRenderer Error: %s\n", SDL_GetError());
+            SDL_FreeSurface(headless_target);
+            SDL_Quit();
+            return false;
+        }
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        if (OVERLAY_ON) {
+            overlay_init(NULL, renderer);
+        }
+        return true;
+    }
+
     window = SDL_CreateWindow("3dsdl", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIDTH, HEIGHT, SDL_WINDOW_SHOWN);
     if (!window) {
         printf("SDL_CreateWindow Error: %s\n", SDL_GetError());
@@ -441,7 +973,14 @@ bool init() {
         return false;
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 renderer_flags = SDL_RENDERER_ACCELERATED;
+    if (options->vsync) {
+        renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    if (options->dynres || RETAINED_FRAMES) {
+        renderer_flags |= SDL_RENDERER_TARGETTEXTURE;
+    }
+    renderer = SDL_CreateRenderer(window, -1, renderer_flags);
     if (!renderer) {
         printf("SDL_CreateRenderer Error: %s\n", SDL_GetError());
         SDL_DestroyWindow(window);
@@ -459,7 +998,7 @@ bool init() {
 
 // Creates a grid of cubes centered around (x, y, z) in world coordinates, with the specified size and color.
 // Optionally leaves a hole in the middle.
-void create_ground_grid(Cube_Map* map, int size, int x, int y, int z, SDL_Color color, int hole_size) {
+void create_ground_grid(World* world, int size, int x, int y, int z, SDL_Color color, int hole_size) {
     const float GRID_OFFSET_X = ((size - 1) * CUBE_SIZE) / 2.0f;
     const float GRID_OFFSET_Z = ((size - 1) * CUBE_SIZE) / 2.0f;
     const float GRID_OFFSET_Y = CUBE_SIZE * 0.5f;
@@ -484,7 +1023,7 @@ void create_ground_grid(Cube_Map* map, int size, int x, int y, int z, SDL_Color
             .y = y * CUBE_SIZE - GRID_OFFSET_Y,
             .z = z * CUBE_SIZE + gz * CUBE_SIZE - GRID_OFFSET_Z
         };
-        Cube* new_cube = (Cube*)malloc(sizeof(Cube));
+        Cube* new_cube = cube_map_new_cube(&world->cubes);
         make_cube(new_cube, CUBE_SIZE, center, color);
 
         Cube_Key key = {
@@ -492,6 +1031,6 @@ void create_ground_grid(Cube_Map* map, int size, int x, int y, int z, SDL_Color
             .y = world_to_grid_coord(center.y, CUBE_SIZE, GRID_OFFSET_Y),
             .z = world_to_grid_coord(center.z, CUBE_SIZE, GRID_OFFSET_Z)
         };
-        cube_map_add(map, key, new_cube);
+        world_add_cube(world, key, new_cube);
     }
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "options.h"
+#include "settings.h"
+
+// Parse an integer argument, returns false if it isn't one
+static bool parse_int(const char* text, long* out) {
+    char* end = NULL;
+    long value = strtol(text, &end, 10);
+    if (!text[0] || *end != '\0') {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+// Parse a decimal argument, returns false if it isn't one
+static bool parse_double(const char* text, double* out) {
+    char* end = NULL;
+    double value = strtod(text, &end);
+    if (!text[0] || *end != '\0') {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+void print_usage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --seed N      generate procedural terrain from seed N\n");
+    printf("  --radius N    terrain size in chunks around the origin (default 4)\n");
+    printf("  --stream      stream terrain within --radius chunks of the player instead of generating it all up front\n");
+    printf("  --world DIR   load the world from (and save it to) region files in DIR, streaming it around the player\n");
+    printf("  --headless    render offscreen without a window or FPS cap (runs --frames frames, default 600)\n");
+    printf("  --frames N    quit after N frames\n");
+    printf("  --bench       fly a scripted camera path uncapped for --frames frames (default 1000) and write timings\n");
+    printf("  --bench-out P benchmark output prefix, writes P.csv and P.json (default bench)\n");
+    printf("  --record FILE record the player's input of every tick into FILE\n");
+    printf("  --replay FILE replay input recorded with --record (runs to the end of it; with --bench, times the replay)\n");
+    printf("  --trace FILE  capture a Chrome trace (chrome://tracing, Perfetto) of the first seconds into FILE\n");
+    printf("  --trace-seconds N  length of trace captures, also the F4 ones (default 5)\n");
+    printf("  --fps N       frame cap, fractions allowed, 0 = uncapped (default %d)\n", TARGET_FPS);
+    printf("  --vsync       pace frames on the display refresh instead of --fps\n");
+    printf("  --hidden-hz N keep simulating at N ticks per second while minimized, 0 = pause (default %d)\n", HIDDEN_TICK_HZ);
+    printf("  --dynres      lower the world's render resolution when frames run over budget\n");
+    printf("  --raster      draw with the multithreaded software rasterizer (z-buffered) instead of SDL geometry\n");
+    printf("  --raycast     draw by casting a ray per pixel through the grid\n");
+    printf("  --threads N   worker threads, 0 = one per extra CPU core (default 0)\n");
+    printf("  --help        show this message\n");
+}
+
+// Fill `options` from the command line (defaults first). Returns false on bad usage.
+bool parse_options(int argc, char** argv, Options* options) {
+    options->use_terrain = false;
+    options->seed = 0;
+    options->terrain_radius = 4;
+    options->threads = 0;
+    options->stream = false;
+    options->world_dir = NULL;
+    options->headless = false;
+    options->frames = 0;
+    options->bench = false;
+    options->bench_out = "bench";
+    options->trace_path = NULL;
+    options->record_path = NULL;
+    options->replay_path = NULL;
+    options->trace_seconds = 5;
+    options->fps = TARGET_FPS;
+    options->hidden_hz = HIDDEN_TICK_HZ;
+    options->vsync = false;
+    options->dynres = false;
+    options->raster = false;
+    options->raycast = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        long number = 0;
+        double decimal = 0.0;
+
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (strcmp(arg, "--seed") == 0 && value && parse_int(value, &number)) {
+            options->use_terrain = true;
+            options->seed = (uint32_t)number;
+            i++;
+        } else if (strcmp(arg, "--radius") == 0 && value && parse_int(value, &number) && number >= 0) {
+            options->terrain_radius = (int)number;
+            i++;
+        } else if (strcmp(arg, "--stream") == 0) {
+            options->stream = true;
+        } else if (strcmp(arg, "--world") == 0 && value) {
+            options->world_dir = value;
+            options->stream = true;
+            i++;
+        } else if (strcmp(arg, "--headless") == 0) {
+            options->headless = true;
+        } else if (strcmp(arg, "--frames") == 0 && value && parse_int(value, &number) && number >= 0) {
+            options->frames = (int)number;
+            i++;
+        } else if (strcmp(arg, "--bench") == 0) {
+            options->bench = true;
+        } else if (strcmp(arg, "--bench-out") == 0 && value) {
+            options->bench_out = value;
+            i++;
+        } else if (strcmp(arg, "--record") == 0 && value) {
+            options->record_path = value;
+            i++;
+        } else if (strcmp(arg, "--replay") == 0 && value) {
+            options->replay_path = value;
+            i++;
+        } else if (strcmp(arg, "--trace") == 0 && value) {
+            options->trace_path = value;
+            i++;
+        } else if (strcmp(arg, "--trace-seconds") == 0 && value && parse_int(value, &number) && number > 0) {
+            options->trace_seconds = (int)number;
+            i++;
+        } else if (strcmp(arg, "--fps") == 0 && value && parse_double(value, &decimal) && decimal >= 0.0) {
+            options->fps = decimal;
+            i++;
+        } else if (strcmp(arg, "--vsync") == 0) {
+            options->vsync = true;
+        } else if (strcmp(arg, "--hidden-hz") == 0 && value && parse_double(value, &decimal) && decimal >= 0.0) {
+            options->hidden_hz = decimal;
+            i++;
+        } else if (strcmp(arg, "--dynres") == 0) {
+            options->dynres = true;
+        } else if (strcmp(arg, "--raster") == 0) {
+            options->raster = true;
+        } else if (strcmp(arg, "--raycast") == 0) {
+            options->raycast = true;
+        } else if (strcmp(arg, "--threads") == 0 && value && parse_int(value, &number) && number >= 0) {
+            options->threads = (int)number;
+            i++;
+        } else {
+            printf("Unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+    if (options->stream && !options->use_terrain && !options->world_dir) {
+        printf("--stream needs a world to stream from (use --seed or --world)\n");
+        return false;
+    }
+    if (options->record_path && options->replay_path) {
+        printf("--record and --replay can't be used together\n");
+        return false;
+    }
+    // A replay runs to the end of its log unless --frames says otherwise
+    if (options->bench && options->frames == 0 && !options->replay_path) {
+        options->frames = 1000;
+    }
+    if (options->headless && options->frames == 0 && !options->replay_path) {
+        options->frames = 600; // nobody can close a window that isn't there
+    }
+    return true;
+}
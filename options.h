@@ -0,0 +1,34 @@
+// options.h - command-line options for 3dsdl
+#ifndef OPTIONS_H
+#define OPTIONS_H
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    bool use_terrain;     // generate procedural terrain instead of the example ground grids
+    uint32_t seed;        // terrain seed
+    int terrain_radius;   // terrain size, in chunks around the origin (or around the player when streaming)
+    bool stream;          // stream terrain around the player on a background thread instead of generating it up front
+    int threads;          // worker threads (0 = one per extra CPU core)
+    const char* world_dir; // directory to load the world from and save it to (NULL = nothing is saved)
+    bool headless;        // render offscreen with a software renderer, no window (and no FPS cap)
+    int frames;           // stop after this many frames (0 = run until quit)
+    bool bench;           // fly a scripted camera path uncapped and write per-stage frame timings
+    const char* bench_out; // benchmark output prefix (<prefix>.csv and <prefix>.json)
+    const char* trace_path; // capture a Chrome trace from startup into this file (NULL = no capture)
+    const char* record_path; // record the player's input to this file (NULL = no recording)
+    const char* replay_path; // drive the simulation from this recorded input instead of the player (NULL = live)
+    int trace_seconds;    // length of trace captures
+    double fps;           // frame cap (0 = uncapped)
+    bool vsync;           // pace frames on the display refresh instead of the cap
+    double hidden_hz;     // simulation ticks per second while the window is minimized (0 = pause)
+    bool dynres;          // scale the world's render resolution to stay within the frame budget
+    bool raster;          // start with the software rasterizer backend
+    bool raycast;         // start with the ray cast backend
+} Options;
+
+// Prototypes
+bool parse_options(int argc, char** argv, Options* options);
+void print_usage(const char* program);
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "pacing.h"
+#include "settings.h"
+
+static const char* MODE_NAMES[] = { "uncapped", "capped", "vsync" };
+
+// Set up `pacer`, with the first frame starting now. target_fps is only used in PACING_CAPPED mode.
+void pacer_init(Frame_Pacer* pacer, Pacing_Mode mode, double target_fps, double spin_ms) {
+    pacer->mode = (mode == PACING_CAPPED && target_fps <= 0.0) ? PACING_UNCAPPED : mode;
+    pacer->frequency = (double)SDL_GetPerformanceFrequency();
+    pacer->period = target_fps > 0.0 ? pacer->frequency / target_fps : 0.0;
+    pacer->spin = spin_ms * pacer->frequency / 1000.0;
+    pacer->epoch = SDL_GetPerformanceCounter();
+    pacer->deadline = pacer->period;
+    pacer->last = pacer->epoch;
+}
+
+// Seconds since the previous call (or since pacer_init)
+double pacer_delta(Frame_Pacer* pacer) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    double seconds = (double)(now - pacer->last) / pacer->frequency;
+    pacer->last = now;
+    return seconds;
+}
+
+// Block until the current frame's deadline, then move the deadline one period on. SDL_Delay only has
+// millisecond granularity and may oversleep by a scheduler quantum, so it only covers the wait up to `spin`
+// before the deadline and the rest is spun on the performance counter.
+void pacer_wait(Frame_Pacer* pacer) {
+    if (pacer->mode != PACING_CAPPED) {
+        return;
+    }
+    double now = (double)(SDL_GetPerformanceCounter() - pacer->epoch);
+    double remaining = pacer->deadline - now;
+    if (remaining > pacer->spin) {
+        Uint32 sleep_ms = (Uint32)((remaining - pacer->spin) * 1000.0 / pacer->frequency);
+        if (sleep_ms > 0) {
+            SDL_Delay(sleep_ms);
+        }
+    }
+    while ((double)(SDL_GetPerformanceCounter() - pacer->epoch) < pacer->deadline) {
+        // spin
+    }
+
+    pacer->deadline += pacer->period;
+    // A frame that ran over by more than a whole period restarts the schedule from now, instead of rushing
+    // the next frames to catch up
+    now = (double)(SDL_GetPerformanceCounter() - pacer->epoch);
+    if (pacer->deadline < now) {
+        pacer->deadline = now + pacer->period;
+    }
+}
+
+const char* pacing_mode_name(Pacing_Mode mode) {
+    return MODE_NAMES[mode];
+}
+
+// Track focus and visibility from a window event. Returns whether either changed. (SDL2 has no occlusion
+// events, a window covered by others still counts as visible.)
+bool window_state_event(Window_State* state, const SDL_WindowEvent* event) {
+    Window_State before = *state;
+    switch (event->event) {
+    case SDL_WINDOWEVENT_FOCUS_GAINED: state->focused = true; break;
+    case SDL_WINDOWEVENT_FOCUS_LOST: state->focused = false; break;
+    case SDL_WINDOWEVENT_MINIMIZED:
+    case SDL_WINDOWEVENT_HIDDEN: state->visible = false; break;
+    case SDL_WINDOWEVENT_RESTORED:
+    case SDL_WINDOWEVENT_MAXIMIZED:
+    case SDL_WINDOWEVENT_SHOWN:
+    case SDL_WINDOWEVENT_EXPOSED: state->visible = true; break;
+    default: break;
+    }
+    return state->focused != before.focused || state->visible != before.visible;
+}
+
+// Frames per second worth making in the given window state: full_fps (0 = uncapped) while focused, at most
+// UNFOCUSED_FPS while visible in the background, and none at all while it can't be seen
+double window_frame_rate(const Window_State* state, double full_fps) {
+    if (!state->visible) {
+        return 0.0;
+    }
+    if (state->focused) {
+        return full_fps;
+    }
+    return (full_fps > 0.0 && full_fps < UNFOCUSED_FPS) ? full_fps : UNFOCUSED_FPS;
+}
@@ -0,0 +1,39 @@
+// pacing.h - high-resolution frame pacing for 3dsdl
+#ifndef PACING_H
+#define PACING_H
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+typedef enum {
+    PACING_UNCAPPED, // run as fast as possible
+    PACING_CAPPED,   // wait for each frame's deadline (sleep, then spin the last stretch)
+    PACING_VSYNC     // let SDL_RenderPresent block on the display's refresh
+} Pacing_Mode;
+
+// Frame deadlines are kept as a fractional tick count from `epoch`, so targets that don't divide the counter
+// frequency (like 240 FPS with a millisecond or nanosecond counter) don't drift.
+typedef struct {
+    Pacing_Mode mode;
+    double frequency;  // performance counter ticks per second
+    double period;     // target frame length in ticks
+    double spin;       // how long before a deadline to stop sleeping and start spinning, in ticks
+    Uint64 epoch;
+    double deadline;   // end of the current frame, in ticks since epoch
+    Uint64 last;       // counter at the previous pacer_delta()
+} Frame_Pacer;
+
+// What the user can see of the window, which decides how many frames are worth making (see window_frame_rate)
+typedef struct {
+    bool focused;
+    bool visible;      // neither minimized nor hidden
+} Window_State;
+
+// Prototypes
+void pacer_init(Frame_Pacer* pacer, Pacing_Mode mode, double target_fps, double spin_ms);
+double pacer_delta(Frame_Pacer* pacer);
+void pacer_wait(Frame_Pacer* pacer);
+const char* pacing_mode_name(Pacing_Mode mode);
+bool window_state_event(Window_State* state, const SDL_WindowEvent* event);
+double window_frame_rate(const Window_State* state, double full_fps);
+
+#endif
@@ -0,0 +1,182 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include "profiler.h"
+
+#if defined(_MSC_VER)
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILE_THREAD_LOCAL _Thread_local
+#endif
+
+// Events of one thread. Only the owning thread writes, publishing each event by bumping `head` afterwards,
+// so readers never need a lock (they only have to stay clear of the oldest slots, which may be rewritten).
+typedef struct {
+    Profile_Event* events;
+    SDL_atomic_t head;
+    char name[32];
+} Profile_Thread;
+
+static Profile_Thread threads[PROFILE_MAX_THREADS];
+static SDL_atomic_t thread_count;
+static SDL_atomic_t current_frame;
+static SDL_atomic_t enabled = { 1 };
+static Uint64 frame_starts[PROFILE_FRAMES];
+
+// Per-thread state: ring slot (-1 = not registered yet, -2 = out of slots) and the open scopes
+static PROFILE_THREAD_LOCAL int thread_index = -1;
+static PROFILE_THREAD_LOCAL int depth;
+static PROFILE_THREAD_LOCAL const char* open_names[PROFILE_MAX_DEPTH];
+static PROFILE_THREAD_LOCAL Uint64 open_starts[PROFILE_MAX_DEPTH];
+
+// Claim a ring for the calling thread on its first event
+static Profile_Thread* current_thread(void) {
+    if (thread_index == -1) {
+        int index = SDL_AtomicAdd(&thread_count, 1);
+        if (index >= PROFILE_MAX_THREADS) {
+            thread_index = -2;
+            return NULL;
+        }
+        Profile_Thread* thread = &threads[index];
+        thread->events = (Profile_Event*)calloc(PROFILE_RING_SIZE, sizeof(Profile_Event));
+        if (!thread->events) {
+            printf("current_thread(): Memory allocation failed. Exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+        if (!thread->name[0]) {
+            snprintf(thread->name, sizeof(thread->name), "thread %d", index);
+        }
+        thread_index = index;
+    }
+    return thread_index >= 0 ? &threads[thread_index] : NULL;
+}
+
+void profiler_set_enabled(bool on) {
+    SDL_AtomicSet(&enabled, on ? 1 : 0);
+}
+
+bool profiler_enabled(void) {
+    return SDL_AtomicGet(&enabled) != 0;
+}
+
+// Label the calling thread's lane in the profiler view
+void profiler_set_thread_name(const char* name) {
+    Profile_Thread* thread = current_thread();
+    if (thread) {
+        snprintf(thread->name, sizeof(thread->name), "%s", name);
+    }
+}
+
+// Mark the start of a new frame (main thread, once per frame)
+void profiler_begin_frame(void) {
+    uint32_t frame = (uint32_t)SDL_AtomicAdd(&current_frame, 1) + 1;
+    frame_starts[frame & (PROFILE_FRAMES - 1)] = SDL_GetPerformanceCounter();
+}
+
+void profile_begin(const char* name) {
+    // Scopes opened while disabled (or too deep) are still counted, so their profile_end() stays balanced
+    if (depth < PROFILE_MAX_DEPTH) {
+        open_names[depth] = SDL_AtomicGet(&enabled) ? name : NULL;
+        open_starts[depth] = open_names[depth] ? SDL_GetPerformanceCounter() : 0;
+    }
+    depth++;
+}
+
+void profile_end(void) {
+    if (depth <= 0) {
+        return;
+    }
+    depth--;
+    if (depth >= PROFILE_MAX_DEPTH || !open_names[depth]) {
+        return;
+    }
+    Profile_Thread* thread = current_thread();
+    if (!thread) {
+        return;
+    }
+    unsigned head = (unsigned)SDL_AtomicGet(&thread->head);
+    Profile_Event* event = &thread->events[head & (PROFILE_RING_SIZE - 1)];
+    event->name = open_names[depth];
+    event->start = open_starts[depth];
+    event->end = SDL_GetPerformanceCounter();
+    event->frame = (uint32_t)SDL_AtomicGet(&current_frame);
+    event->depth = depth;
+    SDL_AtomicSet(&thread->head, (int)(head + 1));
+}
+
+uint32_t profiler_frame(void) {
+    return (uint32_t)SDL_AtomicGet(&current_frame);
+}
+
+// Start time of one of the last PROFILE_FRAMES frames
+Uint64 profiler_frame_start(uint32_t frame) {
+    return frame_starts[frame & (PROFILE_FRAMES - 1)];
+}
+
+int profiler_thread_count(void) {
+    int count = SDL_AtomicGet(&thread_count);
+    return count < PROFILE_MAX_THREADS ? count : PROFILE_MAX_THREADS;
+}
+
+const char* profiler_thread_name(int thread) {
+    return (thread >= 0 && thread < profiler_thread_count()) ? threads[thread].name : "";
+}
+
+// Position of a thread's next event, for starting a profiler_drain() from now on
+unsigned profiler_cursor(int thread_number) {
+    if (thread_number < 0 || thread_number >= profiler_thread_count()) {
+        return 0;
+    }
+    return (unsigned)SDL_AtomicGet(&threads[thread_number].head);
+}
+
+// Copy a thread's events recorded since `*cursor` (oldest first) and move the cursor past them. Events that
+// were already overwritten are skipped and counted in `dropped`. Returns how many were copied.
+size_t profiler_drain(int thread_number, unsigned* cursor, Profile_Event* out, size_t max_events, size_t* dropped) {
+    if (thread_number < 0 || thread_number >= profiler_thread_count() || !threads[thread_number].events) {
+        return 0;
+    }
+    const Profile_Thread* thread = &threads[thread_number];
+    unsigned head = (unsigned)SDL_AtomicGet((SDL_atomic_t*)&thread->head);
+    const unsigned margin = 256;
+    if (head - *cursor > PROFILE_RING_SIZE - margin) {
+        unsigned oldest = head - (PROFILE_RING_SIZE - margin);
+        if (dropped) {
+            *dropped += oldest - *cursor;
+        }
+        *cursor = oldest;
+    }
+    size_t count = 0;
+    while (*cursor != head && count < max_events) {
+        out[count++] = thread->events[*cursor & (PROFILE_RING_SIZE - 1)];
+        (*cursor)++;
+    }
+    return count;
+}
+
+// Copy a thread's events that ended at or after `since` (oldest first), returns how many were copied
+size_t profiler_collect(int thread_number, Uint64 since, Profile_Event* out, size_t max_events) {
+    if (thread_number < 0 || thread_number >= profiler_thread_count() || !threads[thread_number].events) {
+        return 0;
+    }
+    const Profile_Thread* thread = &threads[thread_number];
+    unsigned head = (unsigned)SDL_AtomicGet((SDL_atomic_t*)&thread->head);
+
+    // Walk back from the newest event, keeping a safety margin from the slots the writer may be reusing
+    const unsigned margin = 256;
+    unsigned available = head < PROFILE_RING_SIZE - margin ? head : PROFILE_RING_SIZE - margin;
+    unsigned count = 0;
+    while (count < available && count < max_events) {
+        const Profile_Event* event = &thread->events[(head - 1 - count) & (PROFILE_RING_SIZE - 1)];
+        if (event->end < since) {
+            break;
+        }
+        count++;
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        out[i] = thread->events[(head - count + i) & (PROFILE_RING_SIZE - 1)];
+    }
+    return count;
+}
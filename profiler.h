@@ -0,0 +1,57 @@
+// profiler.h - lightweight hierarchical CPU profiler (scoped markers into per-thread ring buffers) for 3dsdl
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+#define PROFILE_MAX_THREADS 40    // main thread + job workers + loader threads
+#define PROFILE_RING_SIZE 8192    // events kept per thread (power of 2)
+#define PROFILE_FRAMES 128        // frame start times kept (power of 2)
+#define PROFILE_MAX_DEPTH 16
+
+// One finished scope
+typedef struct {
+    const char* name;  // must be a string literal (or otherwise outlive the profiler)
+    Uint64 start;
+    Uint64 end;
+    uint32_t frame;
+    int depth;
+} Profile_Event;
+
+// Scoped markers, always used in pairs in the same function:
+//   PROFILE_BEGIN("clip"); ... PROFILE_END();
+// Building with -DPROFILER_DISABLED compiles them out.
+#ifdef PROFILER_DISABLED
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+#else
+#define PROFILE_BEGIN(name) profile_begin(name)
+#define PROFILE_END() profile_end()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Prototypes
+void profiler_set_enabled(bool enabled);
+bool profiler_enabled(void);
+void profiler_set_thread_name(const char* name);
+void profiler_begin_frame(void);
+void profile_begin(const char* name);
+void profile_end(void);
+uint32_t profiler_frame(void);
+Uint64 profiler_frame_start(uint32_t frame);
+int profiler_thread_count(void);
+const char* profiler_thread_name(int thread);
+size_t profiler_collect(int thread, Uint64 since, Profile_Event* out, size_t max_events);
+unsigned profiler_cursor(int thread);
+size_t profiler_drain(int thread, unsigned* cursor, Profile_Event* out, size_t max_events, size_t* dropped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,350 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "jobs.h"
+#include "profiler.h"
+#include "raster.h"
+#include "settings.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_SSE2 1
+#endif
+
+#define CLEAR_COLOR 0xFF000000u    // opaque black, like the SDL path's clear
+#define OUTLINE_WIDTH 3.0f         // face outline width in pixels at full resolution, like draw_line_thickness
+#define NOT_AN_OUTLINE 1e30f
+#define MAX_FAN_TRIANGLES (MAX_CLIPPED_POINTS - 2) // a quad clipped to the near plane and the guard band
+
+static uint32_t pack_color(SDL_Color color) {
+    return 0xFF000000u | ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | (uint32_t)color.b;
+}
+
+bool raster_init(Software_Rasterizer* raster, SDL_Renderer* renderer) {
+    memset(raster, 0, sizeof(*raster));
+    raster->stride = (WIDTH + 3) & ~3;
+    raster->color = (uint32_t*)malloc((size_t)raster->stride * HEIGHT * sizeof(uint32_t));
+    raster->depth = (float*)malloc((size_t)raster->stride * HEIGHT * sizeof(float));
+    if (!raster->color || !raster->depth) {
+        printf("raster_init(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    raster->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, WIDTH, HEIGHT);
+    if (!raster->texture) {
+        printf("raster_init(): SDL_CreateTexture Error: %s\n", SDL_GetError());
+        raster_free(raster);
+        return false;
+    }
+    SDL_SetTextureBlendMode(raster->texture, SDL_BLENDMODE_NONE);
+    return true;
+}
+
+void raster_free(Software_Rasterizer* raster) {
+    if (raster->texture) {
+        SDL_DestroyTexture(raster->texture);
+    }
+    free(raster->color);
+    free(raster->depth);
+    memset(raster, 0, sizeof(*raster));
+}
+
+// Start a frame of at most `max_polygons` polygons, rendered at `scale` times WIDTH x HEIGHT
+void raster_begin(Software_Rasterizer* raster, Arena* arena, size_t max_polygons, float scale) {
+    raster->scale = scale;
+    raster->width = (int)ceilf(WIDTH * scale);
+    raster->height = (int)ceilf(HEIGHT * scale);
+    raster->width = raster->width < 1 ? 1 : raster->width > WIDTH ? WIDTH : raster->width;
+    raster->height = raster->height < 1 ? 1 : raster->height > HEIGHT ? HEIGHT : raster->height;
+    raster->triangle_capacity = max_polygons * MAX_FAN_TRIANGLES;
+    raster->triangles = ARENA_ALLOC_ARRAY(arena, Raster_Triangle, raster->triangle_capacity);
+    raster->triangle_count = 0;
+    raster->polygon_count = 0;
+}
+
+// The plane a * x + b * y + c through the values v at the corners of a triangle (with twice its signed area)
+static void triangle_plane(const float x[3], const float y[3], const float v[3], float area, float* a, float* b, float* c) {
+    *a = ((v[1] - v[0]) * (y[2] - y[0]) - (v[2] - v[0]) * (y[1] - y[0])) / area;
+    *b = ((v[2] - v[0]) * (x[1] - x[0]) - (v[1] - v[0]) * (x[2] - x[0])) / area;
+    *c = v[0] - *a * x[0] - *b * y[0];
+}
+
+// Set up one triangle (screen space x/y at this frame's scale, 1/z, fill color per corner) and append it.
+// Bit i of outline_edges marks the edge from vertex i to vertex (i + 1) % 3 as part of the polygon's outline.
+static void add_triangle(Software_Rasterizer* raster, const float x[3], const float y[3], const float inv_z[3],
+    unsigned outline_edges, const SDL_Color fill[3], uint32_t outline) {
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (!(fabsf(area) > 1e-6f) || raster->triangle_count >= raster->triangle_capacity) {
+        return;
+    }
+
+    // Bounds, clamped in float first since points far behind the screen edges project to huge coordinates
+    float min_xf = fminf(fminf(x[0], x[1]), x[2]);
+    float max_xf = fmaxf(fmaxf(x[0], x[1]), x[2]);
+    float min_yf = fminf(fminf(y[0], y[1]), y[2]);
+    float max_yf = fmaxf(fmaxf(y[0], y[1]), y[2]);
+    Raster_Triangle* tri = &raster->triangles[raster->triangle_count];
+    tri->min_x = (int)floorf(fmaxf(min_xf, 0.0f));
+    tri->min_y = (int)floorf(fmaxf(min_yf, 0.0f));
+    tri->max_x = (int)ceilf(fminf(max_xf, (float)(raster->width - 1)));
+    tri->max_y = (int)ceilf(fminf(max_yf, (float)(raster->height - 1)));
+    if (tri->min_x > tri->max_x || tri->min_y > tri->max_y) {
+        return;
+    }
+
+    // Edge i runs from vertex i to vertex j. Flipping by the winding makes inside positive either way.
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    for (int i = 0; i < 3; ++i) {
+        int j = (i + 1) % 3;
+        float a = y[i] - y[j];
+        float b = x[j] - x[i];
+        float scale = sign / sqrtf(a * a + b * b);
+        tri->edge_a[i] = a * scale;
+        tri->edge_b[i] = b * scale;
+        tri->edge_c[i] = -(a * x[i] + b * y[i]) * scale;
+        tri->outline_bias[i] = (outline_edges & (1u << i)) ? 0.0f : NOT_AN_OUTLINE;
+    }
+
+    // 1/z is linear in screen space, so depth is a plane. Colors are interpolated in screen space too, like
+    // SDL_RenderGeometry does.
+    triangle_plane(x, y, inv_z, area, &tri->z_a, &tri->z_b, &tri->z_c);
+    tri->fill = pack_color(fill[0]);
+    tri->shaded = tri->fill != pack_color(fill[1]) || tri->fill != pack_color(fill[2]);
+    for (int c = 0; c < 3; ++c) {
+        float v[3];
+        for (int i = 0; i < 3; ++i) {
+            v[i] = c == 0 ? fill[i].r : c == 1 ? fill[i].g : fill[i].b;
+        }
+        triangle_plane(x, y, v, area, &tri->fill_a[c], &tri->fill_b[c], &tri->fill_c[c]);
+    }
+    tri->outline = outline;
+    raster->triangle_count++;
+}
+
+// Add a clipped, projected face (a convex polygon of `count` points, as a triangle fan). Faces are filled with
+// their corner colors at the SDL path's fill alpha over black, and outlined in `color` if `outlined`.
+void raster_add_polygon(Software_Rasterizer* raster, const Projected_Point* projected, const Camera_Point* points, const SDL_Color* colors, size_t count, SDL_Color color, bool outlined) {
+    SDL_Color dim[MAX_CLIPPED_POINTS];
+    for (size_t i = 0; i < count; ++i) {
+        dim[i] = (SDL_Color){ (Uint8)(colors[i].r * 32 / 255), (Uint8)(colors[i].g * 32 / 255), (Uint8)(colors[i].b * 32 / 255), 255 };
+    }
+    uint32_t outline = pack_color(color);
+    for (size_t t = 1; t + 1 < count; ++t) {
+        size_t index[3] = { 0, t, t + 1 };
+        float x[3];
+        float y[3];
+        float inv_z[3];
+        SDL_Color fill[3];
+        for (int v = 0; v < 3; ++v) {
+            x[v] = projected[index[v]].x * raster->scale;
+            y[v] = projected[index[v]].y * raster->scale;
+            inv_z[v] = 1.0f / points[index[v]].z;
+            fill[v] = dim[index[v]];
+        }
+        // The fan's inner diagonals aren't outlines
+        unsigned outline_edges = 2u;
+        if (t == 1) {
+            outline_edges |= 1u;
+        }
+        if (t + 2 == count) {
+            outline_edges |= 4u;
+        }
+        if (!outlined) {
+            outline_edges = 0u;
+        }
+        add_triangle(raster, x, y, inv_z, outline_edges, fill, outline);
+    }
+    raster->polygon_count++;
+}
+
+// Rasterize the part of `tri` inside the pixel rect [x0, x1) x [y0, y1). Spans start on a multiple of 4 and
+// are walked 4 pixels at a time; tiles are multiples of 4 wide (and the buffer stride is padded), so the
+// extra lanes never land in another tile.
+static void draw_triangle(Software_Rasterizer* raster, const Raster_Triangle* tri, int x0, int y0, int x1, int y1, float half_outline) {
+    int min_x = tri->min_x > x0 ? tri->min_x : x0;
+    int max_x = tri->max_x < x1 - 1 ? tri->max_x : x1 - 1;
+    int min_y = tri->min_y > y0 ? tri->min_y : y0;
+    int max_y = tri->max_y < y1 - 1 ? tri->max_y : y1 - 1;
+    if (min_x > max_x || min_y > max_y) {
+        return;
+    }
+    min_x &= ~3;
+
+#ifdef RASTER_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 half = _mm_set1_ps(half_outline);
+    const __m128i fill = _mm_set1_epi32((int)tri->fill);
+    const __m128i outline = _mm_set1_epi32((int)tri->outline);
+    __m128 edge_step[3];
+    __m128 bias[3];
+    for (int i = 0; i < 3; ++i) {
+        edge_step[i] = _mm_set1_ps(tri->edge_a[i] * 4.0f);
+        bias[i] = _mm_set1_ps(tri->outline_bias[i]);
+    }
+    const __m128 z_step = _mm_set1_ps(tri->z_a * 4.0f);
+    const __m128 channel_max = _mm_set1_ps(255.0f);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+    __m128 channel_step[3];
+    for (int c = 0; c < 3; ++c) {
+        channel_step[c] = _mm_set1_ps(tri->fill_a[c] * 4.0f);
+    }
+#endif
+
+    for (int y = min_y; y <= max_y; ++y) {
+        const float px = (float)min_x + 0.5f;
+        const float py = (float)y + 0.5f;
+        uint32_t* color_row = raster->color + (size_t)y * raster->stride;
+        float* depth_row = raster->depth + (size_t)y * raster->stride;
+
+#ifdef RASTER_SSE2
+        __m128 edge[3];
+        for (int i = 0; i < 3; ++i) {
+            float start = tri->edge_a[i] * px + tri->edge_b[i] * py + tri->edge_c[i];
+            edge[i] = _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(_mm_set1_ps(tri->edge_a[i]), lanes));
+        }
+        __m128 z = _mm_add_ps(_mm_set1_ps(tri->z_a * px + tri->z_b * py + tri->z_c), _mm_mul_ps(_mm_set1_ps(tri->z_a), lanes));
+        __m128 channel[3];
+        for (int c = 0; c < 3; ++c) {
+            float start = tri->fill_a[c] * px + tri->fill_b[c] * py + tri->fill_c[c];
+            channel[c] = _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(_mm_set1_ps(tri->fill_a[c]), lanes));
+        }
+
+        for (int x = min_x; x <= max_x; x += 4) {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)), _mm_cmpge_ps(edge[2], zero));
+            __m128 old_depth = _mm_loadu_ps(depth_row + x);
+            __m128 mask = _mm_and_ps(inside, _mm_cmpgt_ps(z, old_depth));
+            if (_mm_movemask_ps(mask)) {
+                __m128 distance = _mm_min_ps(_mm_min_ps(_mm_add_ps(edge[0], bias[0]), _mm_add_ps(edge[1], bias[1])), _mm_add_ps(edge[2], bias[2]));
+                __m128i on_outline = _mm_castps_si128(_mm_cmplt_ps(distance, half));
+                __m128i fill_pixel = fill;
+                if (tri->shaded) {
+                    __m128i r = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(channel[0], zero), channel_max));
+                    __m128i g = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(channel[1], zero), channel_max));
+                    __m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(channel[2], zero), channel_max));
+                    fill_pixel = _mm_or_si128(_mm_or_si128(opaque, _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+                }
+                __m128i pixel = _mm_or_si128(_mm_and_si128(on_outline, outline), _mm_andnot_si128(on_outline, fill_pixel));
+                __m128i write = _mm_castps_si128(mask);
+                __m128i old_color = _mm_loadu_si128((const __m128i*)(color_row + x));
+                _mm_storeu_si128((__m128i*)(color_row + x), _mm_or_si128(_mm_and_si128(write, pixel), _mm_andnot_si128(write, old_color)));
+                _mm_storeu_ps(depth_row + x, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, old_depth)));
+            }
+            for (int i = 0; i < 3; ++i) {
+                edge[i] = _mm_add_ps(edge[i], edge_step[i]);
+            }
+            z = _mm_add_ps(z, z_step);
+            for (int c = 0; c < 3; ++c) {
+                channel[c] = _mm_add_ps(channel[c], channel_step[c]);
+            }
+        }
+#else
+        float edge[3];
+        for (int i = 0; i < 3; ++i) {
+            edge[i] = tri->edge_a[i] * px + tri->edge_b[i] * py + tri->edge_c[i];
+        }
+        float z = tri->z_a * px + tri->z_b * py + tri->z_c;
+        float channel[3];
+        for (int c = 0; c < 3; ++c) {
+            channel[c] = tri->fill_a[c] * px + tri->fill_b[c] * py + tri->fill_c[c];
+        }
+        for (int x = min_x; x <= max_x; ++x) {
+            if (edge[0] >= 0.0f && edge[1] >= 0.0f && edge[2] >= 0.0f && z > depth_row[x]) {
+                float distance = fminf(fminf(edge[0] + tri->outline_bias[0], edge[1] + tri->outline_bias[1]), edge[2] + tri->outline_bias[2]);
+                uint32_t fill = tri->fill;
+                if (tri->shaded) {
+                    SDL_Color shade = {
+                        (Uint8)lroundf(fminf(fmaxf(channel[0], 0.0f), 255.0f)),
+                        (Uint8)lroundf(fminf(fmaxf(channel[1], 0.0f), 255.0f)),
+                        (Uint8)lroundf(fminf(fmaxf(channel[2], 0.0f), 255.0f)),
+                        255
+                    };
+                    fill = pack_color(shade);
+                }
+                color_row[x] = distance < half_outline ? tri->outline : fill;
+                depth_row[x] = z;
+            }
+            for (int i = 0; i < 3; ++i) {
+                edge[i] += tri->edge_a[i];
+                channel[i] += tri->fill_a[i];
+            }
+            z += tri->z_a;
+        }
+#endif
+    }
+}
+
+// Clear one tile, then draw every triangle binned to it. Tiles don't share pixels, so they run in parallel.
+static void raster_tile_job(void* userdata, size_t index, int worker) {
+    (void)worker;
+    Software_Rasterizer* raster = (Software_Rasterizer*)userdata;
+    PROFILE_BEGIN("raster tile");
+    int x0 = (int)(index % (size_t)raster->tiles_x) * RASTER_TILE_SIZE;
+    int y0 = (int)(index / (size_t)raster->tiles_x) * RASTER_TILE_SIZE;
+    int x1 = x0 + RASTER_TILE_SIZE < raster->width ? x0 + RASTER_TILE_SIZE : raster->width;
+    int y1 = y0 + RASTER_TILE_SIZE < raster->height ? y0 + RASTER_TILE_SIZE : raster->height;
+
+    for (int y = y0; y < y1; ++y) {
+        uint32_t* color_row = raster->color + (size_t)y * raster->stride;
+        memset(raster->depth + (size_t)y * raster->stride + x0, 0, (size_t)(x1 - x0) * sizeof(float));
+        for (int x = x0; x < x1; ++x) {
+            color_row[x] = CLEAR_COLOR;
+        }
+    }
+
+    float half_outline = OUTLINE_WIDTH * 0.5f * raster->scale;
+    for (uint32_t t = raster->tile_start[index]; t < raster->tile_start[index + 1]; ++t) {
+        draw_triangle(raster, &raster->triangles[raster->tile_triangles[t]], x0, y0, x1, y1, half_outline);
+    }
+    PROFILE_END();
+}
+
+// Bin the frame's triangles to the tiles they overlap, rasterize the tiles across the job pool, then upload
+// the result and copy it over the whole (logical) screen
+void raster_draw(Software_Rasterizer* raster, SDL_Renderer* renderer, Arena* arena) {
+    PROFILE_BEGIN("bin");
+    raster->tiles_x = (raster->width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    raster->tiles_y = (raster->height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    size_t tile_count = (size_t)raster->tiles_x * (size_t)raster->tiles_y;
+
+    // Count per tile, prefix sum into start offsets, then scatter (triangles keep their order within a tile)
+    raster->tile_start = ARENA_ALLOC_ARRAY(arena, uint32_t, tile_count + 1);
+    memset(raster->tile_start, 0, (tile_count + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < raster->triangle_count; ++i) {
+        const Raster_Triangle* tri = &raster->triangles[i];
+        for (int ty = tri->min_y / RASTER_TILE_SIZE; ty <= tri->max_y / RASTER_TILE_SIZE; ++ty) {
+            for (int tx = tri->min_x / RASTER_TILE_SIZE; tx <= tri->max_x / RASTER_TILE_SIZE; ++tx) {
+                raster->tile_start[(size_t)ty * raster->tiles_x + tx + 1]++;
+            }
+        }
+    }
+    for (size_t t = 0; t < tile_count; ++t) {
+        raster->tile_start[t + 1] += raster->tile_start[t];
+    }
+    uint32_t* cursor = ARENA_ALLOC_ARRAY(arena, uint32_t, tile_count);
+    memcpy(cursor, raster->tile_start, tile_count * sizeof(uint32_t));
+    raster->tile_triangles = ARENA_ALLOC_ARRAY(arena, uint32_t, raster->tile_start[tile_count]);
+    for (size_t i = 0; i < raster->triangle_count; ++i) {
+        const Raster_Triangle* tri = &raster->triangles[i];
+        for (int ty = tri->min_y / RASTER_TILE_SIZE; ty <= tri->max_y / RASTER_TILE_SIZE; ++ty) {
+            for (int tx = tri->min_x / RASTER_TILE_SIZE; tx <= tri->max_x / RASTER_TILE_SIZE; ++tx) {
+                raster->tile_triangles[cursor[(size_t)ty * raster->tiles_x + tx]++] = (uint32_t)i;
+            }
+        }
+    }
+    PROFILE_END();
+
+    PROFILE_BEGIN("rasterize");
+    jobs_parallel_for(tile_count, raster_tile_job, raster);
+    PROFILE_END();
+
+    PROFILE_BEGIN("upload");
+    SDL_Rect source = { 0, 0, raster->width, raster->height };
+    SDL_Rect screen = { 0, 0, WIDTH, HEIGHT };
+    SDL_UpdateTexture(raster->texture, &source, raster->color, raster->stride * (int)sizeof(uint32_t));
+    SDL_RenderCopy(renderer, raster->texture, &source, &screen);
+    PROFILE_END();
+}
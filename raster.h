@@ -0,0 +1,62 @@
+// raster.h - tile-binned, multithreaded software rasterizer with a z-buffer for 3dsdl
+#ifndef RASTER_H
+#define RASTER_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "arena.h"
+#include "data_structures.h"
+
+#define RASTER_TILE_SIZE 64  // tile side in pixels (multiple of 4, the SIMD width)
+
+// A triangle set up for rasterization. The edge functions are normalized, so they give the signed distance in
+// pixels from each edge (positive inside), which doubles as the inside test and the outline test.
+typedef struct {
+    float edge_a[3];
+    float edge_b[3];
+    float edge_c[3];
+    float outline_bias[3]; // 0 for edges on the face's outline, huge for the fan's inner edges
+    float z_a;             // 1/z plane over the screen: z_a * x + z_b * y + z_c
+    float z_b;
+    float z_c;
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+    uint32_t fill;         // fill color, when it's the same at all three corners
+    bool shaded;           // otherwise (Gouraud) each fill channel is a plane: fill_a[c] * x + fill_b[c] * y + fill_c[c]
+    float fill_a[3];
+    float fill_b[3];
+    float fill_c[3];
+    uint32_t outline;
+} Raster_Triangle;
+
+// Renders the frame's faces into its own color and depth buffers (WIDTH x HEIGHT at most, the top-left
+// `width` x `height` of them at lower render scales), which are uploaded to one streaming texture.
+typedef struct {
+    SDL_Texture* texture;
+    uint32_t* color;
+    float* depth;           // 1/z, 0 = nothing drawn (so bigger is closer)
+    int stride;             // pixels per buffer row
+    int width;              // this frame's resolution
+    int height;
+    float scale;
+    Raster_Triangle* triangles;
+    size_t triangle_count;
+    size_t triangle_capacity;
+    size_t polygon_count;
+    int tiles_x;
+    int tiles_y;
+    uint32_t* tile_start;   // tiles_x * tiles_y + 1 offsets into tile_triangles
+    uint32_t* tile_triangles;
+} Software_Rasterizer;
+
+// Prototypes
+bool raster_init(Software_Rasterizer* raster, SDL_Renderer* renderer);
+void raster_free(Software_Rasterizer* raster);
+void raster_begin(Software_Rasterizer* raster, Arena* arena, size_t max_polygons, float scale);
+void raster_add_polygon(Software_Rasterizer* raster, const Projected_Point* projected, const Camera_Point* points, const SDL_Color* colors, size_t count, SDL_Color color, bool outlined);
+void raster_draw(Software_Rasterizer* raster, SDL_Renderer* renderer, Arena* arena);
+
+#endif
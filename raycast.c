@@ -0,0 +1,164 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "jobs.h"
+#include "profiler.h"
+#include "raycast.h"
+#include "rendering.h"
+#include "settings.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MISS_COLOR 0xFF000000u     // opaque black, like the other backends' clear
+#define OUTLINE_WIDTH 3.0f         // cube edge width in pixels at full resolution, like the other backends
+
+static uint32_t pack_color(SDL_Color color) {
+    return 0xFF000000u | ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | (uint32_t)color.b;
+}
+
+bool raycast_init(Raycast_Renderer* raycaster, SDL_Renderer* renderer) {
+    memset(raycaster, 0, sizeof(*raycaster));
+    raycaster->pixels = (uint32_t*)malloc((size_t)WIDTH * HEIGHT * sizeof(uint32_t));
+    if (!raycaster->pixels) {
+        printf("raycast_init(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    raycaster->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, WIDTH, HEIGHT);
+    if (!raycaster->texture) {
+        printf("raycast_init(): SDL_CreateTexture Error: %s\n", SDL_GetError());
+        raycast_free(raycaster);
+        return false;
+    }
+    SDL_SetTextureBlendMode(raycaster->texture, SDL_BLENDMODE_NONE);
+    return true;
+}
+
+void raycast_free(Raycast_Renderer* raycaster) {
+    if (raycaster->texture) {
+        SDL_DestroyTexture(raycaster->texture);
+    }
+    free(raycaster->pixels);
+    memset(raycaster, 0, sizeof(*raycaster));
+}
+
+// Camera space direction to world space (the inverse of transform_to_camera's rotation)
+static Point_3D camera_to_world_dir(const Camera_Basis* basis, float x, float y, float z) {
+    float world_y = basis->pitch_cos * y - basis->pitch_sin * z;
+    float z1 = basis->pitch_sin * y + basis->pitch_cos * z;
+    return (Point_3D){
+        .x = basis->yaw_cos * x + basis->yaw_sin * z1,
+        .y = world_y,
+        .z = -basis->yaw_sin * x + basis->yaw_cos * z1
+    };
+}
+
+// Shade a hit like the other backends draw faces: the cube's color dimmed (and shaded by the direction of the
+// face that was hit) as a fill, full color near the edges of that face (measured in screen pixels, so outlines
+// keep their width with distance) unless it's past OUTLINE_MAX_DISTANCE. Fog goes by the distance along the
+// ray. Ambient occlusion is left out, it would cost several cell lookups per ray.
+static uint32_t shade_hit(const Raycast_Renderer* raycaster, const Ray_Hit* hit, Point_3D dir, float depth) {
+    const Cube* cube = world_get_cube(raycaster->world, hit->key);
+    if (!cube) {
+        return MISS_COLOR;
+    }
+    SDL_Color color = cube->color;
+    if (raycaster->fog) {
+        color = apply_fog(color, hit->distance, raycaster->fog_start, raycaster->max_distance);
+    }
+    float shade = world_face_shade(hit->normal_x, hit->normal_y, hit->normal_z) * 32.0f / 255.0f;
+    SDL_Color dim = { (Uint8)(color.r * shade), (Uint8)(color.g * shade), (Uint8)(color.b * shade), 255 };
+    const int normal[3] = { hit->normal_x, hit->normal_y, hit->normal_z };
+    if ((normal[0] == 0 && normal[1] == 0 && normal[2] == 0) || depth >= OUTLINE_MAX_DISTANCE) {
+        return pack_color(dim); // started inside the cube, or too far for an outline
+    }
+
+    // Hit point in grid units, where cell edges sit at integer + 0.5
+    const World* world = raycaster->world;
+    const float eye[3] = { raycaster->camera.x + world->offset_x, raycaster->camera.y + world->offset_y, raycaster->camera.z + world->offset_z };
+    const float d[3] = { dir.x, dir.y, dir.z };
+    float pixel_size = 2.0f * depth / (raycaster->camera.focal_length * (float)HEIGHT) / world->step;
+    float half_outline = OUTLINE_WIDTH * 0.5f * pixel_size;
+    for (int a = 0; a < 3; ++a) {
+        if (normal[a] != 0) {
+            continue;
+        }
+        float u = (eye[a] + d[a] * hit->distance) / world->step + 0.5f;
+        float f = u - floorf(u);
+        if (f < half_outline || 1.0f - f < half_outline) {
+            return pack_color(color);
+        }
+    }
+    return pack_color(dim);
+}
+
+// Cast the rays of one row. The camera space direction of a ray is linear along the row, so it's stepped.
+static void raycast_row_job(void* userdata, size_t index, int worker) {
+    (void)worker;
+    Raycast_Renderer* raycaster = (Raycast_Renderer*)userdata;
+    const int y = (int)index;
+    const float focal = raycaster->camera.focal_length;
+    const float sy = ((float)y + 0.5f) * (float)HEIGHT / (float)raycaster->height;
+    const float y_ndc = 1.0f - 2.0f * sy / (float)HEIGHT;
+    const float cam_y = y_ndc / focal;
+    const float x_step = 2.0f / (float)raycaster->width * ASPECT_RATIO / focal;
+    float cam_x = (-1.0f + 1.0f / (float)raycaster->width) * ASPECT_RATIO / focal;
+
+    const Point_3D eye = { raycaster->camera.x, raycaster->camera.y, raycaster->camera.z };
+    uint32_t* row = raycaster->pixels + (size_t)y * WIDTH;
+    size_t hits = 0;
+    for (int x = 0; x < raycaster->width; ++x, cam_x += x_step) {
+        float len = sqrtf(cam_x * cam_x + cam_y * cam_y + 1.0f);
+        Point_3D dir = camera_to_world_dir(&raycaster->basis, cam_x / len, cam_y / len, 1.0f / len);
+        Ray_Hit hit;
+        if (world_raycast(raycaster->world, eye, dir, raycaster->max_distance, &hit)) {
+            // hit.distance runs along the normalized ray, the camera space depth is its z part
+            row[x] = shade_hit(raycaster, &hit, dir, hit.distance / len);
+            hits++;
+        } else {
+            row[x] = MISS_COLOR;
+        }
+    }
+    raycaster->row_hits[index] = hits;
+}
+
+// Ray cast the world from `camera` at `scale` times the screen resolution, one ray per ray_block x ray_block
+// pixels up to the view distance, and copy the image over the whole (logical) screen. Returns the number of
+// rays that hit a cube.
+size_t raycast_draw(Raycast_Renderer* raycaster, SDL_Renderer* renderer, Arena* arena, const World* world, const Camera* camera, float scale, const Render_Settings* settings) {
+    int block = settings->ray_block < 1 ? 1 : settings->ray_block;
+    raycaster->width = (int)ceilf(WIDTH * scale) / block;
+    raycaster->height = (int)ceilf(HEIGHT * scale) / block;
+    raycaster->width = raycaster->width < 1 ? 1 : raycaster->width > WIDTH ? WIDTH : raycaster->width;
+    raycaster->height = raycaster->height < 1 ? 1 : raycaster->height > HEIGHT ? HEIGHT : raycaster->height;
+    raycaster->world = world;
+    raycaster->camera = *camera;
+    raycaster->max_distance = settings->view_distance;
+    raycaster->fog_start = settings->view_distance * FOG_START;
+    raycaster->fog = settings->fog;
+    float yaw_rad = camera->yaw * (float)(M_PI / 180.0);
+    float pitch_rad = camera->pitch * (float)(M_PI / 180.0);
+    raycaster->basis = (Camera_Basis){ cosf(yaw_rad), sinf(yaw_rad), cosf(pitch_rad), sinf(pitch_rad) };
+    raycaster->row_hits = ARENA_ALLOC_ARRAY(arena, size_t, (size_t)raycaster->height);
+
+    PROFILE_BEGIN("cast rays");
+    jobs_parallel_for((size_t)raycaster->height, raycast_row_job, raycaster);
+    PROFILE_END();
+    size_t hits = 0;
+    for (int y = 0; y < raycaster->height; ++y) {
+        hits += raycaster->row_hits[y];
+    }
+
+    PROFILE_BEGIN("upload");
+    SDL_Rect source = { 0, 0, raycaster->width, raycaster->height };
+    SDL_Rect screen = { 0, 0, WIDTH, HEIGHT };
+    SDL_UpdateTexture(raycaster->texture, &source, raycaster->pixels, WIDTH * (int)sizeof(uint32_t));
+    SDL_RenderCopy(renderer, raycaster->texture, &source, &screen);
+    PROFILE_END();
+    return hits;
+}
@@ -0,0 +1,34 @@
+// raycast.h - multithreaded voxel ray-casting render mode for 3dsdl
+#ifndef RAYCAST_H
+#define RAYCAST_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "arena.h"
+#include "data_structures.h"
+#include "world.h"
+
+// Casts one ray per pixel (or per block x block pixels) through the grid with world_raycast, which skips
+// empty chunks whole. Rows are spread across the job pool and the image goes to one streaming texture,
+// so the cost follows the resolution rather than the number of cubes.
+typedef struct {
+    SDL_Texture* texture;
+    uint32_t* pixels;       // WIDTH x HEIGHT at most, the top-left width x height used
+    int width;              // this frame's resolution, in rays
+    int height;
+    const World* world;
+    Camera camera;
+    Camera_Basis basis;
+    float max_distance;     // the view distance, where fog (if on) starts at fog_start
+    float fog_start;
+    bool fog;
+    size_t* row_hits;       // rays that hit a cube, per row
+} Raycast_Renderer;
+
+// Prototypes
+bool raycast_init(Raycast_Renderer* raycaster, SDL_Renderer* renderer);
+void raycast_free(Raycast_Renderer* raycaster);
+size_t raycast_draw(Raycast_Renderer* raycaster, SDL_Renderer* renderer, Arena* arena, const World* world, const Camera* camera, float scale, const Render_Settings* settings);
+
+#endif
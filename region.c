@@ -0,0 +1,452 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "region.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Region file layout (all integers little-endian):
+//   header:  "3DSR", u32 version, i32 region x/y/z, u32 chunk count (REGION_CHUNKS), 8 reserved bytes
+//   table:   REGION_CHUNKS x { u32 offset, u32 size }, offset 0 = chunk not stored
+//   payload: u32 cube count, u16 palette size, palette RGBA colors, u16 run count, runs of { u16 length, u16 index }
+//            where index 0 is an empty cell and index i > 0 is palette color i - 1, in Chunk_Data cell order.
+// Chunks saved again are rewritten in place when they fit, appended to the end of the file otherwise.
+#define REGION_MAGIC "3DSR"
+#define REGION_VERSION 1u
+#define REGION_HEADER_SIZE 32u
+#define REGION_TABLE_SIZE (REGION_CHUNKS * 8u)
+#define REGION_MAX_PAYLOAD (4u + 2u + CHUNK_VOLUME * 4u + 2u + CHUNK_VOLUME * 4u)
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Floor division for chunk -> region coordinates
+static int region_coord(int v) {
+    return (v >= 0) ? (v / REGION_SIZE) : -((-v + REGION_SIZE - 1) / REGION_SIZE);
+}
+
+static Cube_Key region_key_for(Cube_Key chunk_key) {
+    Cube_Key key = { .x = region_coord(chunk_key.x), .y = region_coord(chunk_key.y), .z = region_coord(chunk_key.z) };
+    return key;
+}
+
+// Index of a chunk in its region's offset table
+static size_t region_slot(Cube_Key chunk_key, Cube_Key region_key) {
+    int lx = chunk_key.x - region_key.x * REGION_SIZE;
+    int ly = chunk_key.y - region_key.y * REGION_SIZE;
+    int lz = chunk_key.z - region_key.z * REGION_SIZE;
+    return (size_t)lx + REGION_SIZE * ((size_t)ly + REGION_SIZE * (size_t)lz);
+}
+
+static void region_path(const Region_Store* store, Cube_Key region_key, char* out, size_t out_size) {
+    snprintf(out, out_size, "%s/r.%d.%d.%d.3dr", store->dir, region_key.x, region_key.y, region_key.z);
+}
+
+// Map a whole file read-only. Returns false if it doesn't exist or can't be mapped.
+static bool map_file(const char* path, const uint8_t** data, size_t* size, void** handle) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    *data = (const uint8_t*)view;
+    *size = (size_t)file_size.QuadPart;
+    *handle = mapping;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    *data = (const uint8_t*)view;
+    *size = (size_t)st.st_size;
+    *handle = NULL;
+    return true;
+#endif
+}
+
+static void unmap_file(const uint8_t* data, size_t size, void* handle) {
+    if (!data) {
+        return;
+    }
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)handle);
+#else
+    (void)handle;
+    munmap((void*)data, size);
+#endif
+}
+
+static void region_unmap(Region_File* region) {
+    unmap_file(region->data, region->size, region->map_handle);
+    region->data = NULL;
+    region->size = 0;
+    region->map_handle = NULL;
+    region->exists = false;
+}
+
+// (Re)map a region file and check its header, leaving it marked missing if anything is off
+static void region_remap(const Region_Store* store, Region_File* region) {
+    region_unmap(region);
+
+    char path[1024];
+    region_path(store, region->key, path, sizeof(path));
+    if (!map_file(path, &region->data, &region->size, &region->map_handle)) {
+        return;
+    }
+    if (region->size < REGION_HEADER_SIZE + REGION_TABLE_SIZE || memcmp(region->data, REGION_MAGIC, 4) != 0 ||
+        get_u32(region->data + 4) != REGION_VERSION || get_u32(region->data + 20) != REGION_CHUNKS) {
+        printf("Ignoring invalid region file: %s\n", path);
+        region_unmap(region);
+        return;
+    }
+    region->exists = true;
+}
+
+// Find (or lazily open) the region with the given key. Call with the mutex held.
+static Region_File* region_get(Region_Store* store, Cube_Key region_key) {
+    for (size_t i = 0; i < store->region_count; ++i) {
+        Cube_Key k = store->regions[i].key;
+        if (k.x == region_key.x && k.y == region_key.y && k.z == region_key.z) {
+            return &store->regions[i];
+        }
+    }
+    if (store->region_count == store->region_capacity) {
+        store->region_capacity = store->region_capacity ? store->region_capacity * 2 : 16;
+        store->regions = (Region_File*)realloc(store->regions, store->region_capacity * sizeof(Region_File));
+    }
+    Region_File* region = &store->regions[store->region_count++];
+    *region = (Region_File){ .key = region_key };
+    region_remap(store, region);
+    return region;
+}
+
+// Open a world directory (created if missing). No region file is touched until a chunk in it is needed.
+bool region_store_open(Region_Store* store, const char* dir) {
+    if (!store || !dir) {
+        return false;
+    }
+    *store = (Region_Store){0};
+#ifdef _WIN32
+    _mkdir(dir);
+#else
+    mkdir(dir, 0755);
+#endif
+    store->dir = (char*)malloc(strlen(dir) + 1);
+    strcpy(store->dir, dir);
+    store->mutex = SDL_CreateMutex();
+    return store->mutex != NULL;
+}
+
+void region_store_close(Region_Store* store) {
+    if (!store || !store->mutex) {
+        return;
+    }
+    for (size_t i = 0; i < store->region_count; ++i) {
+        unmap_file(store->regions[i].data, store->regions[i].size, store->regions[i].map_handle);
+    }
+    free(store->regions);
+    free(store->dir);
+    SDL_DestroyMutex(store->mutex);
+    *store = (Region_Store){0};
+}
+
+// Whether the directory holds any region file at all (i.e. this isn't a brand new world)
+bool region_store_has_data(Region_Store* store) {
+    bool found = false;
+#ifdef _WIN32
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s/r.*.3dr", store->dir);
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA(pattern, &find_data);
+    if (find != INVALID_HANDLE_VALUE) {
+        found = true;
+        FindClose(find);
+    }
+#else
+    DIR* dir = opendir(store->dir);
+    if (dir) {
+        struct dirent* entry;
+        while (!found && (entry = readdir(dir)) != NULL) {
+            size_t len = strlen(entry->d_name);
+            found = len > 4 && strncmp(entry->d_name, "r.", 2) == 0 && strcmp(entry->d_name + len - 4, ".3dr") == 0;
+        }
+        closedir(dir);
+    }
+#endif
+    return found;
+}
+
+// Decode one chunk payload, returns false if it is malformed
+static bool decode_chunk(const uint8_t* p, size_t size, Chunk_Data* out) {
+    SDL_Color palette[CHUNK_VOLUME];
+    if (size < 6) {
+        return false;
+    }
+    uint32_t cube_count = get_u32(p);
+    uint16_t palette_count = get_u16(p + 4);
+    size_t pos = 6;
+    if (palette_count > CHUNK_VOLUME || pos + (size_t)palette_count * 4 + 2 > size) {
+        return false;
+    }
+    for (uint16_t i = 0; i < palette_count; ++i, pos += 4) {
+        palette[i] = (SDL_Color){ p[pos], p[pos + 1], p[pos + 2], p[pos + 3] };
+    }
+    uint16_t run_count = get_u16(p + pos);
+    pos += 2;
+    if (pos + (size_t)run_count * 4 > size) {
+        return false;
+    }
+
+    size_t cell = 0;
+    size_t filled = 0;
+    for (uint16_t r = 0; r < run_count; ++r, pos += 4) {
+        uint16_t length = get_u16(p + pos);
+        uint16_t index = get_u16(p + pos + 2);
+        if (cell + length > CHUNK_VOLUME || index > palette_count) {
+            return false;
+        }
+        if (index == 0) {
+            cell += length;
+            continue;
+        }
+        for (uint16_t i = 0; i < length; ++i) {
+            out->cells[cell++] = palette[index - 1];
+        }
+        filled += length;
+    }
+    out->cube_count = filled;
+    return cell == CHUNK_VOLUME && filled == cube_count;
+}
+
+// Load one chunk from disk. Returns false if it has never been saved (or can't be read).
+bool region_store_load_chunk(Region_Store* store, Cube_Key chunk_key, Chunk_Data* out) {
+    if (!store || !out) {
+        return false;
+    }
+    out->key = chunk_key;
+    out->cube_count = 0;
+    memset(out->cells, 0, sizeof(out->cells));
+
+    bool loaded = false;
+    SDL_LockMutex(store->mutex);
+    Cube_Key region_key = region_key_for(chunk_key);
+    Region_File* region = region_get(store, region_key);
+    if (region->exists) {
+        const uint8_t* entry = region->data + REGION_HEADER_SIZE + region_slot(chunk_key, region_key) * 8;
+        uint32_t offset = get_u32(entry);
+        uint32_t size = get_u32(entry + 4);
+        if (offset != 0) {
+            if ((size_t)offset + size <= region->size && decode_chunk(region->data + offset, size, out)) {
+                loaded = true;
+            } else {
+                printf("Corrupt chunk (%d, %d, %d) in region (%d, %d, %d), ignoring it\n",
+                       chunk_key.x, chunk_key.y, chunk_key.z, region_key.x, region_key.y, region_key.z);
+                out->cube_count = 0;
+                memset(out->cells, 0, sizeof(out->cells));
+            }
+        }
+    }
+    SDL_UnlockMutex(store->mutex);
+    return loaded;
+}
+
+// Encode a chunk as palette + run lengths, returns the payload size
+static size_t encode_chunk(const Chunk_Data* data, uint8_t* p) {
+    SDL_Color palette[CHUNK_VOLUME];
+    uint16_t palette_count = 0;
+    uint16_t indices[CHUNK_VOLUME];
+
+    for (size_t i = 0; i < CHUNK_VOLUME; ++i) {
+        SDL_Color c = data->cells[i];
+        if (c.a == 0) {
+            indices[i] = 0;
+            continue;
+        }
+        // Chunks rarely hold more than a handful of colors, so a linear search is fine
+        uint16_t index = 0;
+        for (uint16_t k = 0; k < palette_count; ++k) {
+            if (palette[k].r == c.r && palette[k].g == c.g && palette[k].b == c.b && palette[k].a == c.a) {
+                index = (uint16_t)(k + 1);
+                break;
+            }
+        }
+        if (index == 0) {
+            palette[palette_count++] = c;
+            index = palette_count;
+        }
+        indices[i] = index;
+    }
+
+    put_u32(p, (uint32_t)data->cube_count);
+    put_u16(p + 4, palette_count);
+    size_t pos = 6;
+    for (uint16_t k = 0; k < palette_count; ++k, pos += 4) {
+        p[pos] = palette[k].r;
+        p[pos + 1] = palette[k].g;
+        p[pos + 2] = palette[k].b;
+        p[pos + 3] = palette[k].a;
+    }
+    size_t run_count_pos = pos;
+    pos += 2;
+    uint16_t run_count = 0;
+    for (size_t i = 0; i < CHUNK_VOLUME;) {
+        size_t j = i + 1;
+        while (j < CHUNK_VOLUME && indices[j] == indices[i]) {
+            j++;
+        }
+        put_u16(p + pos, (uint16_t)(j - i));
+        put_u16(p + pos + 2, indices[i]);
+        pos += 4;
+        run_count++;
+        i = j;
+    }
+    put_u16(p + run_count_pos, run_count);
+    return pos;
+}
+
+// Write one chunk into its region file (creating the file if needed)
+bool region_store_save_chunk(Region_Store* store, const Chunk_Data* data) {
+    if (!store || !data) {
+        return false;
+    }
+    uint8_t* payload = (uint8_t*)malloc(REGION_MAX_PAYLOAD);
+    if (!payload) {
+        return false;
+    }
+    size_t payload_size = encode_chunk(data, payload);
+
+    SDL_LockMutex(store->mutex);
+    Cube_Key region_key = region_key_for(data->key);
+    Region_File* region = region_get(store, region_key);
+    size_t table_pos = REGION_HEADER_SIZE + region_slot(data->key, region_key) * 8;
+    uint32_t old_offset = region->exists ? get_u32(region->data + table_pos) : 0;
+    uint32_t old_size = region->exists ? get_u32(region->data + table_pos + 4) : 0;
+    size_t file_size = region->exists ? region->size : 0;
+    bool existed = region->exists;
+
+    // Drop the mapping while writing (it is refreshed afterwards to see the new table and payload)
+    region_unmap(region);
+    char path[1024];
+    region_path(store, region_key, path, sizeof(path));
+    FILE* file = fopen(path, existed ? "r+b" : "w+b");
+    bool ok = file != NULL;
+    if (ok && !existed) {
+        // New region: header plus an empty table
+        uint8_t* header = (uint8_t*)calloc(1, REGION_HEADER_SIZE + REGION_TABLE_SIZE);
+        memcpy(header, REGION_MAGIC, 4);
+        put_u32(header + 4, REGION_VERSION);
+        put_u32(header + 8, (uint32_t)region_key.x);
+        put_u32(header + 12, (uint32_t)region_key.y);
+        put_u32(header + 16, (uint32_t)region_key.z);
+        put_u32(header + 20, REGION_CHUNKS);
+        ok = fwrite(header, 1, REGION_HEADER_SIZE + REGION_TABLE_SIZE, file) == REGION_HEADER_SIZE + REGION_TABLE_SIZE;
+        free(header);
+        file_size = REGION_HEADER_SIZE + REGION_TABLE_SIZE;
+    }
+
+    uint32_t offset = (old_offset != 0 && payload_size <= old_size) ? old_offset : (uint32_t)file_size;
+    if (ok) {
+        uint8_t entry[8];
+        put_u32(entry, offset);
+        put_u32(entry + 4, (uint32_t)payload_size);
+        ok = fseek(file, (long)offset, SEEK_SET) == 0 && fwrite(payload, 1, payload_size, file) == payload_size &&
+             fseek(file, (long)table_pos, SEEK_SET) == 0 && fwrite(entry, 1, sizeof(entry), file) == sizeof(entry);
+    }
+    if (file) {
+        ok = (fclose(file) == 0) && ok;
+    }
+    if (!ok) {
+        printf("Failed to save chunk (%d, %d, %d) to %s\n", data->key.x, data->key.y, data->key.z, path);
+    }
+    region_remap(store, region);
+    SDL_UnlockMutex(store->mutex);
+
+    free(payload);
+    return ok;
+}
+
+// Save every dirty chunk of the world and mark them clean, returns how many were written
+size_t region_store_save_world(Region_Store* store, World* world) {
+    if (!store || !world) {
+        return 0;
+    }
+    Chunk_Data* data = (Chunk_Data*)malloc(sizeof(Chunk_Data));
+    size_t saved = 0;
+    size_t capacity = chunk_map_capacity(&world->chunks);
+    for (size_t i = 0; i < capacity && data; ++i) {
+        const Chunk_Map_Entry* entry = chunk_map_entry_at(&world->chunks, i);
+        if (!entry->occupied || !entry->chunk || !entry->chunk->dirty) {
+            continue;
+        }
+        world_extract_chunk_data(world, entry->chunk->key, data);
+        if (region_store_save_chunk(store, data)) {
+            entry->chunk->dirty = false;
+            saved++;
+        }
+    }
+    free(data);
+    return saved;
+}
+
+// Chunk sink for streaming (see streaming.h): userdata is the Region_Store
+void region_store_sink(void* userdata, const Chunk_Data* data) {
+    region_store_save_chunk((Region_Store*)userdata, data);
+}
@@ -0,0 +1,42 @@
+// region.h - on-disk world storage (region files with a chunk offset table) for 3dsdl
+#ifndef REGION_H
+#define REGION_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "data_structures.h"
+#include "world.h"
+
+// Each region file covers REGION_SIZE^3 chunks
+#define REGION_SIZE 8
+#define REGION_CHUNKS (REGION_SIZE * REGION_SIZE * REGION_SIZE)
+
+// One region file. Its chunk table and payloads are read straight from a read-only memory mapping,
+// so opening a region costs nothing until a chunk is actually decoded.
+typedef struct {
+    Cube_Key key;
+    bool exists;
+    const uint8_t* data;
+    size_t size;
+    void* map_handle;
+} Region_File;
+
+// A world directory holding region files. All functions are thread-safe.
+typedef struct {
+    char* dir;
+    SDL_mutex* mutex;
+    Region_File* regions;
+    size_t region_count;
+    size_t region_capacity;
+} Region_Store;
+
+// Prototypes
+bool region_store_open(Region_Store* store, const char* dir);
+void region_store_close(Region_Store* store);
+bool region_store_has_data(Region_Store* store);
+bool region_store_load_chunk(Region_Store* store, Cube_Key chunk_key, Chunk_Data* out);
+bool region_store_save_chunk(Region_Store* store, const Chunk_Data* data);
+size_t region_store_save_world(Region_Store* store, World* world);
+void region_store_sink(void* userdata, const Chunk_Data* data);
+
+#endif
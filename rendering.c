@@ -1,5 +1,8 @@
+#include <string.h>
 #include <SDL2/SDL.h>
+#include "arena.h"
 #include "data_structures.h"
+#include "profiler.h"
 #include "settings.h"
 
 #include <math.h>
@@ -10,6 +13,13 @@
 extern Camera camera;          // defined in main.c
 extern SDL_Renderer *renderer; // defined in main.c
 
+static size_t line_call_count = 0; // SDL_RenderDrawLine calls so far, for the counters panel
+
+// Total SDL_RenderDrawLine calls made through draw_line_thickness()
+size_t draw_line_calls(void) {
+    return line_call_count;
+}
+
 // Draw a line with integer thickness by drawing several parallel lines.
 void draw_line_thickness(int x1, int y1, int x2, int y2, int thickness)
 {
@@ -21,6 +31,7 @@ void draw_line_thickness(int x1, int y1, int x2, int y2, int thickness)
     int dy = y2 - y1;
     int start = -(thickness / 2);
     int end = start + thickness - 1;
+    line_call_count += (size_t)(end - start + 1);
 
     if (abs(dx) > abs(dy))
     {
@@ -67,31 +78,32 @@ void draw_crosshair(int thickness, int size)
     draw_line_thickness(cx, cy - half, cx, cy + half, thickness);
 }
 
-// Compute the 8 cube points in camera space after applying camera translation + yaw/pitch rotation.
-void compute_camera_points(const Cube *cube, Camera_Point out[8]) {
+// Compute the camera's yaw/pitch rotation terms (once per frame, shared by every transformed point).
+Camera_Basis compute_camera_basis(void) {
     float yaw_rad = camera.yaw * (M_PI / 180.0f);
     float pitch_rad = camera.pitch * (M_PI / 180.0f);
-    float yaw_cos = cosf(yaw_rad);
-    float yaw_sin = sinf(yaw_rad);
-    float pitch_cos = cosf(pitch_rad);
-    float pitch_sin = sinf(pitch_rad);
+    Camera_Basis basis = {
+        .yaw_cos = cosf(yaw_rad),
+        .yaw_sin = sinf(yaw_rad),
+        .pitch_cos = cosf(pitch_rad),
+        .pitch_sin = sinf(pitch_rad)
+    };
+    return basis;
+}
 
-    for (size_t i = 0; i < 8; ++i)
-    {
-        float rel_x = cube->points[i].x - camera.x;
-        float rel_y = cube->points[i].y - camera.y;
-        float rel_z = cube->points[i].z - camera.z;
+// Transform a world point into camera space (camera translation + yaw/pitch rotation).
+Camera_Point transform_to_camera(const Camera_Basis *basis, Point_3D p) {
+    float rel_x = p.x - camera.x;
+    float rel_y = p.y - camera.y;
+    float rel_z = p.z - camera.z;
 
-        float x1 = yaw_cos * rel_x - yaw_sin * rel_z;
-        float z1 = yaw_sin * rel_x + yaw_cos * rel_z;
+    float x1 = basis->yaw_cos * rel_x - basis->yaw_sin * rel_z;
+    float z1 = basis->yaw_sin * rel_x + basis->yaw_cos * rel_z;
 
-        float y2 = pitch_cos * rel_y + pitch_sin * z1;
-        float z2 = -pitch_sin * rel_y + pitch_cos * z1;
+    float y2 = basis->pitch_cos * rel_y + basis->pitch_sin * z1;
+    float z2 = -basis->pitch_sin * rel_y + basis->pitch_cos * z1;
 
-        out[i].x = x1;
-        out[i].y = y2;
-        out[i].z = z2;
-    }
+    return (Camera_Point){.x = x1, .y = y2, .z = z2};
 }
 
 // Project a camera space point to screen space.
@@ -103,63 +115,131 @@ Projected_Point project_to_screen(const Camera_Point *p) {
     return (Projected_Point){.x = sx, .y = sy};
 }
 
-// Near-plane clipping (Sutherland-Hodgman against z >= z_near).
-size_t clip_polygon_near(const Camera_Point* in_pts, size_t in_count, float z_near, Camera_Point* out_pts) {
-    if (in_count == 0) {
-        return 0;
+// Frustum planes, as outcode bits
+enum {
+    FRUSTUM_NEAR = 1 << 0,
+    FRUSTUM_LEFT = 1 << 1,
+    FRUSTUM_RIGHT = 1 << 2,
+    FRUSTUM_BOTTOM = 1 << 3,
+    FRUSTUM_TOP = 1 << 4
+};
+
+// Which side of a frustum plane a camera space point is on (>= 0 inside, linear in the point). The side planes
+// are at `band` times the screen's half width/height: 1 for the screen itself, GUARD_BAND for the guard band.
+static float frustum_plane_side(const Camera_Point* p, unsigned plane, float z_near, float band) {
+    switch (plane) {
+    case FRUSTUM_NEAR: return p->z - z_near;
+    case FRUSTUM_LEFT: return band * p->z + p->x * camera.focal_length / ASPECT_RATIO;
+    case FRUSTUM_RIGHT: return band * p->z - p->x * camera.focal_length / ASPECT_RATIO;
+    case FRUSTUM_BOTTOM: return band * p->z + p->y * camera.focal_length;
+    default: return band * p->z - p->y * camera.focal_length;
+    }
+}
+
+// Outcode of a camera space point: a bit for every frustum plane it's outside of
+static unsigned frustum_outcode(const Camera_Point* p, float z_near, float band) {
+    unsigned code = 0;
+    for (unsigned plane = FRUSTUM_NEAR; plane <= FRUSTUM_TOP; plane <<= 1) {
+        if (frustum_plane_side(p, plane, z_near, band) < 0.0f) {
+            code |= plane;
+        }
     }
+    return code;
+}
 
+// Sutherland-Hodgman against one frustum plane (writes at most MAX_CLIPPED_POINTS points)
+static size_t clip_polygon_plane(const Camera_Point* in_pts, size_t in_count, unsigned plane, float z_near, float band, Camera_Point* out_pts) {
     size_t out_count = 0;
     Camera_Point prev = in_pts[in_count - 1];
-    bool prev_inside = prev.z >= z_near;
-
-    for (size_t i = 0; i < in_count; ++i) {
+    float prev_side = frustum_plane_side(&prev, plane, z_near, band);
+    for (size_t i = 0; i < in_count && out_count < MAX_CLIPPED_POINTS; ++i) {
         Camera_Point curr = in_pts[i];
-        bool curr_inside = curr.z >= z_near;
-
-        if (curr_inside && prev_inside) {
-            out_pts[out_count++] = curr;
-        } else if (prev_inside && !curr_inside) {
-            float t = (z_near - prev.z) / (curr.z - prev.z);
-            Camera_Point intersect = {
-                .x = prev.x + (curr.x - prev.x) * t,
-                .y = prev.y + (curr.y - prev.y) * t,
-                .z = z_near
-            };
-            out_pts[out_count++] = intersect;
-        } else if (!prev_inside && curr_inside) {
-            float t = (z_near - prev.z) / (curr.z - prev.z);
+        float curr_side = frustum_plane_side(&curr, plane, z_near, band);
+        if ((prev_side >= 0.0f) != (curr_side >= 0.0f)) {
+            float t = prev_side / (prev_side - curr_side);
             Camera_Point intersect = {
                 .x = prev.x + (curr.x - prev.x) * t,
                 .y = prev.y + (curr.y - prev.y) * t,
-                .z = z_near
+                .z = plane == FRUSTUM_NEAR ? z_near : prev.z + (curr.z - prev.z) * t
             };
             out_pts[out_count++] = intersect;
+        }
+        if (curr_side >= 0.0f && out_count < MAX_CLIPPED_POINTS) {
             out_pts[out_count++] = curr;
         }
-
         prev = curr;
-        prev_inside = curr_inside;
+        prev_side = curr_side;
     }
-
     return out_count;
 }
 
-// Check if a polygon is completely offscreen.
-bool polygon_completely_offscreen(const Projected_Point* pts, size_t count) {
-    bool all_left = true;
-    bool all_right = true;
-    bool all_top = true;
-    bool all_bottom = true;
+// Clip a camera space polygon to the view frustum, before anything gets projected. Polygons entirely outside
+// one of the screen's planes are rejected, and those within the near plane and the guard band are passed
+// through as they are (the renderer clips them to the screen cheaply). Only the rest are clipped, against
+// just the planes they cross, so nothing projected lands further out than the guard band. Writes the points
+// (at most MAX_CLIPPED_POINTS) to out_pts and their number to out_count (0 unless inside or clipped).
+Frustum_Result clip_polygon_frustum(const Camera_Point* in_pts, size_t in_count, float z_near, Camera_Point* out_pts, size_t* out_count) {
+    *out_count = 0;
+    unsigned screen_all = ~0u;
+    unsigned guard_any = 0;
+    for (size_t i = 0; i < in_count; ++i) {
+        screen_all &= frustum_outcode(&in_pts[i], z_near, 1.0f);
+        guard_any |= frustum_outcode(&in_pts[i], z_near, GUARD_BAND);
+    }
+    if (in_count < 3 || (screen_all & FRUSTUM_NEAR)) {
+        return FRUSTUM_BEHIND;
+    }
+    if (screen_all) {
+        return FRUSTUM_OUTSIDE;
+    }
+    if (!guard_any) {
+        memcpy(out_pts, in_pts, in_count * sizeof(Camera_Point));
+        *out_count = in_count;
+        return FRUSTUM_INSIDE;
+    }
 
-    for (size_t i = 0; i < count; ++i) {
-        all_left = all_left && (pts[i].x < 0.0f);
-        all_right = all_right && (pts[i].x > (float)WIDTH);
-        all_top = all_top && (pts[i].y < 0.0f);
-        all_bottom = all_bottom && (pts[i].y > (float)HEIGHT);
+    Camera_Point buffers[2][MAX_CLIPPED_POINTS];
+    const Camera_Point* points = in_pts;
+    size_t count = in_count;
+    int target = 0;
+    for (unsigned plane = FRUSTUM_NEAR; plane <= FRUSTUM_TOP; plane <<= 1) {
+        if (!(guard_any & plane)) {
+            continue;
+        }
+        count = clip_polygon_plane(points, count, plane, z_near, GUARD_BAND, buffers[target]);
+        if (count < 3) {
+            return FRUSTUM_OUTSIDE;
+        }
+        points = buffers[target];
+        target ^= 1;
     }
+    memcpy(out_pts, points, count * sizeof(Camera_Point));
+    *out_count = count;
+    return FRUSTUM_CLIPPED;
+}
 
-    return all_left || all_right || all_top || all_bottom;
+// Corner colors of a clipped face: bilinear over the face's rectangle `quad` (corners in order around it),
+// at each of the `count` points clipped from it
+void interpolate_quad_colors(const Camera_Point quad[4], const SDL_Color colors[4], const Camera_Point* points, size_t count, SDL_Color* out) {
+    const Camera_Point u = { quad[1].x - quad[0].x, quad[1].y - quad[0].y, quad[1].z - quad[0].z };
+    const Camera_Point v = { quad[3].x - quad[0].x, quad[3].y - quad[0].y, quad[3].z - quad[0].z };
+    const float u_len2 = u.x * u.x + u.y * u.y + u.z * u.z;
+    const float v_len2 = v.x * v.x + v.y * v.y + v.z * v.z;
+    for (size_t i = 0; i < count; ++i) {
+        Camera_Point p = { points[i].x - quad[0].x, points[i].y - quad[0].y, points[i].z - quad[0].z };
+        float s = u_len2 > 0.0f ? fminf(fmaxf((p.x * u.x + p.y * u.y + p.z * u.z) / u_len2, 0.0f), 1.0f) : 0.0f;
+        float t = v_len2 > 0.0f ? fminf(fmaxf((p.x * v.x + p.y * v.y + p.z * v.z) / v_len2, 0.0f), 1.0f) : 0.0f;
+        float w[4] = { (1.0f - s) * (1.0f - t), s * (1.0f - t), s * t, (1.0f - s) * t };
+        float r = 0.0f;
+        float g = 0.0f;
+        float b = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            r += w[c] * colors[c].r;
+            g += w[c] * colors[c].g;
+            b += w[c] * colors[c].b;
+        }
+        out[i] = (SDL_Color){ (Uint8)(r + 0.5f), (Uint8)(g + 0.5f), (Uint8)(b + 0.5f), colors[0].a };
+    }
 }
 
 // Comparison function for qsort to sort faces by depth descending.
@@ -173,4 +253,64 @@ int compare_face_depth_desc(const void* a, const void* b) {
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+// Fade a color into the clear color (black) between fog_start and fog_end world units from the eye
+SDL_Color apply_fog(SDL_Color color, float distance, float fog_start, float fog_end) {
+    if (distance <= fog_start) {
+        return color;
+    }
+    float keep = distance >= fog_end ? 0.0f : (fog_end - distance) / (fog_end - fog_start);
+    return (SDL_Color){ (Uint8)(color.r * keep), (Uint8)(color.g * keep), (Uint8)(color.b * keep), color.a };
+}
+
+// Fill the (depth-sorted) faces as one batch of triangles, then draw their outlines on top, both in Painter's
+// order. The vertex buffer is carved from `arena`. Adds what was submitted to `counters` (if not NULL).
+void submit_faces(const Render_Face* faces, size_t face_count, Arena* arena, Render_Counters* counters) {
+    PROFILE_BEGIN("fill");
+    size_t total_verts = 0;
+    for (size_t i = 0; i < face_count; ++i) {
+        total_verts += faces[i].vert_count;
+    }
+
+    SDL_Vertex* verts = ARENA_ALLOC_ARRAY(arena, SDL_Vertex, total_verts);
+    size_t write_index = 0;
+    for (size_t i = 0; i < face_count; ++i) {
+        for (size_t v = 0; v < faces[i].vert_count; ++v) {
+            verts[write_index++] = faces[i].verts[v];
+        }
+    }
+
+    // Fill triangles in Painter's order (sorted by depth)
+    if (total_verts > 0) {
+        SDL_RenderGeometry(renderer, NULL, verts, (int)total_verts, NULL, 0);
+    }
+    PROFILE_END();
+    if (counters) {
+        counters->vertices += total_verts;
+        counters->triangles += total_verts / 3;
+        counters->geometry_calls += total_verts > 0 ? 1 : 0;
+        counters->verts_capacity = total_verts;
+    }
+
+    // Draw face outlines on top of filled faces for better visibility, also in Painter's order
+    PROFILE_BEGIN("outlines");
+    for (size_t i = 0; i < face_count; ++i) {
+        const Render_Face* face = &faces[i];
+        if (face->line_count < 2) {
+            continue;
+        }
+        SDL_SetRenderDrawColor(renderer, face->color.r, face->color.g, face->color.b, 255);
+        const int outline_thickness = 3;
+        for (size_t p = 0; p < face->line_count; ++p) {
+            size_t next = (p + 1) % face->line_count;
+            draw_line_thickness(
+                (int)SDL_roundf(face->line_pts[p].x),
+                (int)SDL_roundf(face->line_pts[p].y),
+                (int)SDL_roundf(face->line_pts[next].x),
+                (int)SDL_roundf(face->line_pts[next].y),
+                outline_thickness);
+        }
+    }
+    PROFILE_END();
+}
@@ -4,10 +4,14 @@
 // Prototypes
 void draw_line_thickness(int x1, int y1, int x2, int y2, int thickness);
 void draw_crosshair(int thickness, int size);
-void compute_camera_points(const Cube *cube, Camera_Point out[8]);
+Camera_Basis compute_camera_basis(void);
+Camera_Point transform_to_camera(const Camera_Basis *basis, Point_3D p);
 Projected_Point project_to_screen(const Camera_Point *p);
-size_t clip_polygon_near(const Camera_Point* in_pts, size_t in_count, float z_near, Camera_Point* out_pts);
-bool polygon_completely_offscreen(const Projected_Point* pts, size_t count);
+Frustum_Result clip_polygon_frustum(const Camera_Point* in_pts, size_t in_count, float z_near, Camera_Point* out_pts, size_t* out_count);
+void interpolate_quad_colors(const Camera_Point quad[4], const SDL_Color colors[4], const Camera_Point* points, size_t count, SDL_Color* out);
 int compare_face_depth_desc(const void* a, const void* b);
+SDL_Color apply_fog(SDL_Color color, float distance, float fog_start, float fog_end);
+void submit_faces(const Render_Face* faces, size_t face_count, Arena* arena, Render_Counters* counters);
+size_t draw_line_calls(void);
 
 #endif
\ No newline at end of file
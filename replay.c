@@ -0,0 +1,159 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+
+// Input log layout (all integers little-endian):
+//   header: "3DSI", u32 version, u32 flags (bit 0 = procedural terrain), u32 terrain seed, i32 terrain radius,
+//           12 reserved bytes
+//   ticks:  { f32 dt (IEEE bits), u16 INPUT_* buttons, i16 look dx/dy, i16 late look dx/dy, 2 reserved bytes }
+// Mouse motion beyond the i16 range within one tick is clamped.
+#define INPUT_LOG_MAGIC "3DSI"
+#define INPUT_LOG_VERSION 1u
+#define INPUT_LOG_HEADER_SIZE 32u
+#define INPUT_LOG_TICK_SIZE 16u
+#define INPUT_LOG_TERRAIN 1u
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_i16(uint8_t* p, int v) {
+    v = v < INT16_MIN ? INT16_MIN : v > INT16_MAX ? INT16_MAX : v;
+    put_u16(p, (uint16_t)(int16_t)v);
+}
+
+static int get_i16(const uint8_t* p) {
+    return (int16_t)get_u16(p);
+}
+
+// The world options the log was (or is being) recorded with
+static void encode_header(uint8_t* header, const Options* options) {
+    memset(header, 0, INPUT_LOG_HEADER_SIZE);
+    memcpy(header, INPUT_LOG_MAGIC, 4);
+    put_u32(header + 4, INPUT_LOG_VERSION);
+    put_u32(header + 8, options->use_terrain ? INPUT_LOG_TERRAIN : 0u);
+    put_u32(header + 12, options->use_terrain ? options->seed : 0u);
+    put_u32(header + 16, options->use_terrain ? (uint32_t)options->terrain_radius : 0u);
+}
+
+// Start recording to `path` (truncated). Returns false if it can't be written.
+bool input_log_record(Input_Log* log, const char* path, const Options* options) {
+    memset(log, 0, sizeof(*log));
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        printf("Failed to open input log for recording: %s\n", path);
+        return false;
+    }
+    uint8_t header[INPUT_LOG_HEADER_SIZE];
+    encode_header(header, options);
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        printf("Failed to write input log: %s\n", path);
+        fclose(file);
+        return false;
+    }
+    log->file = file;
+    log->path = path;
+    return true;
+}
+
+// Open `path` for replay. A log recorded in a different world still replays (with a warning), but won't
+// follow the same path.
+bool input_log_replay(Input_Log* log, const char* path, const Options* options) {
+    memset(log, 0, sizeof(*log));
+    FILE* file = fopen(path, "rb");
+    uint8_t header[INPUT_LOG_HEADER_SIZE];
+    if (!file || fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, INPUT_LOG_MAGIC, 4) != 0 ||
+        get_u32(header + 4) != INPUT_LOG_VERSION) {
+        printf("Not a readable input log: %s\n", path);
+        if (file) {
+            fclose(file);
+        }
+        return false;
+    }
+    uint8_t expected[INPUT_LOG_HEADER_SIZE];
+    encode_header(expected, options);
+    if (memcmp(header, expected, INPUT_LOG_HEADER_SIZE) != 0) {
+        if (get_u32(header + 8) & INPUT_LOG_TERRAIN) {
+            printf("Warning: %s was recorded with --seed %u --radius %d\n", path, (unsigned)get_u32(header + 12), (int)get_u32(header + 16));
+        } else {
+            printf("Warning: %s was recorded without --seed\n", path);
+        }
+    }
+    long start = ftell(file);
+    if (start >= 0 && fseek(file, 0, SEEK_END) == 0) {
+        long end = ftell(file);
+        log->tick_count = end > start ? (size_t)(end - start) / INPUT_LOG_TICK_SIZE : 0;
+        fseek(file, start, SEEK_SET);
+    }
+    if (log->tick_count == 0) {
+        printf("Input log has no ticks: %s\n", path);
+        fclose(file);
+        return false;
+    }
+    log->file = file;
+    log->path = path;
+    return true;
+}
+
+void input_log_close(Input_Log* log) {
+    if (log->file && fclose(log->file) != 0) {
+        printf("Failed to write input log: %s\n", log->path);
+    }
+    memset(log, 0, sizeof(*log));
+}
+
+// Append one tick. On a write error the recording stops (and the log keeps the ticks before it).
+bool input_log_write(Input_Log* log, const Input_Tick* tick) {
+    uint8_t record[INPUT_LOG_TICK_SIZE] = {0};
+    uint32_t dt_bits;
+    memcpy(&dt_bits, &tick->dt, sizeof(dt_bits));
+    put_u32(record, dt_bits);
+    put_u16(record + 4, tick->buttons);
+    put_i16(record + 6, tick->look_dx);
+    put_i16(record + 8, tick->look_dy);
+    put_i16(record + 10, tick->late_dx);
+    put_i16(record + 12, tick->late_dy);
+    if (fwrite(record, 1, sizeof(record), log->file) != sizeof(record)) {
+        printf("Failed to write input log: %s\n", log->path);
+        input_log_close(log);
+        return false;
+    }
+    log->tick++;
+    return true;
+}
+
+// Read the next tick. Returns false at the end of the log.
+bool input_log_read(Input_Log* log, Input_Tick* tick) {
+    uint8_t record[INPUT_LOG_TICK_SIZE];
+    if (fread(record, 1, sizeof(record), log->file) != sizeof(record)) {
+        return false;
+    }
+    uint32_t dt_bits = get_u32(record);
+    memcpy(&tick->dt, &dt_bits, sizeof(dt_bits));
+    tick->buttons = get_u16(record + 4);
+    tick->look_dx = get_i16(record + 6);
+    tick->look_dy = get_i16(record + 8);
+    tick->late_dx = get_i16(record + 10);
+    tick->late_dy = get_i16(record + 12);
+    log->tick++;
+    return true;
+}
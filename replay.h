@@ -0,0 +1,26 @@
+// replay.h - recording player input to a binary log and replaying it deterministically in 3dsdl
+#ifndef REPLAY_H
+#define REPLAY_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "input.h"
+#include "options.h"
+
+// A --record or --replay input log: a header naming the world it was played in, then one fixed-size record per
+// simulation tick. Replaying a log on the same world re-runs the same camera path, physics and block edits.
+typedef struct {
+    FILE* file;          // NULL = not recording / replaying
+    const char* path;
+    size_t tick;         // ticks written or read so far
+    size_t tick_count;   // ticks in the log (replay only)
+} Input_Log;
+
+// Prototypes
+bool input_log_record(Input_Log* log, const char* path, const Options* options);
+bool input_log_replay(Input_Log* log, const char* path, const Options* options);
+void input_log_close(Input_Log* log);
+bool input_log_write(Input_Log* log, const Input_Tick* tick);
+bool input_log_read(Input_Log* log, Input_Tick* tick);
+
+#endif
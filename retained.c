@@ -0,0 +1,77 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "retained.h"
+#include "settings.h"
+
+// Changes smaller than this (world units, degrees, focal length) are far below a pixel, and the walk bob and
+// FOV easing only approach their resting values asymptotically
+#define KEY_EPSILON 1e-4f
+
+bool retained_init(Retained_Frame* retained, SDL_Renderer* renderer) {
+    memset(retained, 0, sizeof(*retained));
+    retained->target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, WIDTH, HEIGHT);
+    if (!retained->target) {
+        printf("retained_init(): SDL_CreateTexture Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(retained->target, SDL_BLENDMODE_NONE);
+    return true;
+}
+
+void retained_free(Retained_Frame* retained) {
+    if (retained->target) {
+        SDL_DestroyTexture(retained->target);
+    }
+    memset(retained, 0, sizeof(*retained));
+}
+
+static bool close_enough(float a, float b) {
+    return fabsf(a - b) < KEY_EPSILON;
+}
+
+// Compared field by field (not with memcmp, because of padding), so new render settings need adding here
+static bool render_settings_equal(const Render_Settings* a, const Render_Settings* b) {
+    return a->backend == b->backend && a->backface_culling == b->backface_culling && a->ray_block == b->ray_block &&
+           a->chunk_lod == b->chunk_lod && a->view_distance == b->view_distance && a->fog == b->fog &&
+           a->retained == b->retained && a->late_latch == b->late_latch;
+}
+
+// Whether this frame's world image would match the retained one. Either way, the frame about to be drawn (or
+// reused) is what gets retained next.
+bool retained_match(Retained_Frame* retained, const Render_Key* key) {
+    const Camera* a = &retained->key.camera;
+    const Camera* b = &key->camera;
+    bool same = retained->valid &&
+                close_enough(a->x, b->x) && close_enough(a->y, b->y) && close_enough(a->z, b->z) &&
+                close_enough(a->yaw, b->yaw) && close_enough(a->pitch, b->pitch) &&
+                close_enough(a->focal_length, b->focal_length) &&
+                retained->key.world_revision == key->world_revision &&
+                retained->key.render_scale == key->render_scale &&
+                render_settings_equal(&retained->key.settings, &key->settings);
+    if (!same) {
+        retained->key = *key;
+    }
+    retained->valid = true;
+    retained->reused = same ? retained->reused + 1 : 0;
+    return same;
+}
+
+// Forget the retained image (e.g. when the renderer lost its render targets)
+void retained_invalidate(Retained_Frame* retained) {
+    retained->valid = false;
+    retained->reused = 0;
+}
+
+// Draw the world into the retained image
+void retained_begin(Retained_Frame* retained, SDL_Renderer* renderer) {
+    SDL_SetRenderTarget(renderer, retained->target);
+}
+
+// Back to the window, and copy the retained image over it
+void retained_end(Retained_Frame* retained, SDL_Renderer* renderer) {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderCopy(renderer, retained->target, NULL, NULL);
+}
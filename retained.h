@@ -0,0 +1,36 @@
+// retained.h - reuse of the last world image while nothing it depends on changes, for 3dsdl
+#ifndef RETAINED_H
+#define RETAINED_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "data_structures.h"
+
+// Everything the world image depends on
+typedef struct {
+    Camera camera;            // pose (with the walk bob) and focal length (FOV)
+    uint64_t world_revision;
+    Render_Settings settings;
+    float render_scale;
+} Render_Key;
+
+// While the key stays the same, the world image of the last frame is copied to the screen again instead of
+// being rendered, so standing still only costs the overlay and the present. The image lives in `target`, or
+// in the dynamic resolution target when that's on.
+typedef struct {
+    SDL_Texture* target;      // WIDTH x HEIGHT render target
+    Render_Key key;           // what the retained image was rendered with
+    bool valid;
+    size_t reused;            // frames in a row drawn from the retained image
+} Retained_Frame;
+
+// Prototypes
+bool retained_init(Retained_Frame* retained, SDL_Renderer* renderer);
+void retained_free(Retained_Frame* retained);
+bool retained_match(Retained_Frame* retained, const Render_Key* key);
+void retained_invalidate(Retained_Frame* retained);
+void retained_begin(Retained_Frame* retained, SDL_Renderer* renderer);
+void retained_end(Retained_Frame* retained, SDL_Renderer* renderer);
+
+#endif
@@ -4,8 +4,18 @@
 // Global consts for window dimensions and frame rate
 const int WIDTH = 1600;
 const int HEIGHT = 900;
-const int TARGET_FPS = 240;
-const uint32_t FRAME_DELAY = (1000u / TARGET_FPS);
+const int TARGET_FPS = 240;              // default frame cap (--fps)
+const float PACING_SPIN_MS = 1.5f;       // frame pacing stops sleeping this long before a deadline and spins instead
+
+// Background throttling: frame cap while the window is visible but unfocused, and simulation ticks per second
+// while it's minimized or hidden (--hidden-hz, 0 = pause until it's back; nothing is drawn either way)
+const float UNFOCUSED_FPS = 30.0f;
+const int HIDDEN_TICK_HZ = 0;
+const int HIDDEN_WAIT_MS = 250;          // longest sleep in the event queue while paused
+
+// Dynamic resolution (--dynres)
+const float DYNRES_MIN_SCALE = 0.5f;     // lowest linear render scale
+const float DYNRES_HEADROOM = 0.9f;      // part of the frame budget the controller aims for
 
 // Global consts for stats overlay
 const bool OVERLAY_ON = true;
@@ -18,10 +28,49 @@ const float FOV_LERP_SPEED = 6.0f;
 const float PITCH_MAX = 89.0f;
 const float PITCH_MIN = -89.0f;
 const float MOUSE_SENSITIVITY = 0.1f; // degrees per pixel
+// Apply mouse motion that came in during the frame's simulation right before rendering it, not just after the
+// event loop (can be toggled in the counters panel)
+const bool LATE_LATCH = true;
+
+// Side clip planes of the guard band, as a multiple of the screen's half width/height: faces reaching past
+// them are clipped in camera space, smaller ones are left for the renderer to clip to the screen
+const float GUARD_BAND = 4.0f;
 
 // Global consts for cubes
 const float CUBE_SIZE = 2.0f;
 
+// Block picking (crosshair ray) reach
+const float PICK_DISTANCE = 12.0f; // world units
+
+// Skip faces pointing away from the camera (can be toggled in the counters panel)
+const bool BACKFACE_CULLING = true;
+
+// Skip rendering the world while the camera, the world and the render settings don't change, and copy the
+// last image instead (can be toggled in the counters panel)
+const bool RETAINED_FRAMES = true;
+
+// Lighting baked into the chunk meshes when they're built: faces are shaded by the direction they face, and
+// their corners darkened by the cubes around them (ambient occlusion), by up to AO_STRENGTH
+const bool VOXEL_LIGHTING = true;
+const float AO_STRENGTH = 0.6f;
+
+// Chunk level of detail (can be toggled in the counters panel): a chunk switches to cubes merged 2x2x2 once its
+// cubes would be smaller than LOD_CUBE_PIXELS on screen, and to 4x4x4 below half that. A switch only happens
+// LOD_HYSTERESIS (relative) past a threshold, so chunks sitting on one don't flicker between levels.
+const bool CHUNK_LOD = true;
+const float LOD_CUBE_PIXELS = 16.0f;
+const float LOD_HYSTERESIS = 0.15f;
+const float OUTLINE_MAX_DISTANCE = 112.0f; // world units, faces further away are drawn without outlines
+
+// Draw distance (world units): chunks entirely further away are skipped, and rays stop there. With fog, faces
+// fade into the clear color from FOG_START of the way there. All of it can be changed in the counters panel.
+const float VIEW_DISTANCE = 160.0f;
+const bool FOG = true;
+const float FOG_START = 0.6f;
+
+// Ray cast backend: pixels per ray side (1 or 2, can be toggled in the counters panel)
+const int RAYCAST_BLOCK = 1;
+
 // Gravity, falling and jumping
 const float GRAVITY = 30.0f;
 const float FALL_RESET_DISTANCE = 200.0f;
@@ -7,7 +7,16 @@
 extern const int WIDTH;
 extern const int HEIGHT;
 extern const int TARGET_FPS;
-extern const uint32_t FRAME_DELAY;
+extern const float PACING_SPIN_MS;
+
+// Frame rates while the window is in the background
+extern const float UNFOCUSED_FPS;
+extern const int HIDDEN_TICK_HZ;
+extern const int HIDDEN_WAIT_MS;
+
+// Dynamic resolution
+extern const float DYNRES_MIN_SCALE;
+extern const float DYNRES_HEADROOM;
 
 // Global consts for stats overlay
 extern const bool OVERLAY_ON;
@@ -20,10 +29,41 @@ extern const float FOV_LERP_SPEED;
 extern const float PITCH_MAX;
 extern const float PITCH_MIN;
 extern const float MOUSE_SENSITIVITY;
+extern const bool LATE_LATCH;
+
+// Faces inside the guard band go to the renderer unclipped (see clip_polygon_frustum)
+extern const float GUARD_BAND;
 
 // Global consts for cubes
 extern const float CUBE_SIZE;
 
+// Block picking (crosshair ray) reach
+extern const float PICK_DISTANCE;
+
+// Skip faces pointing away from the camera (can be toggled in the counters panel)
+extern const bool BACKFACE_CULLING;
+
+// Reuse the last world image while the view doesn't change
+extern const bool RETAINED_FRAMES;
+
+// Lighting baked into the chunk meshes
+extern const bool VOXEL_LIGHTING;
+extern const float AO_STRENGTH;
+
+// Chunk level of detail and face outlines
+extern const bool CHUNK_LOD;
+extern const float LOD_CUBE_PIXELS;
+extern const float LOD_HYSTERESIS;
+extern const float OUTLINE_MAX_DISTANCE;
+
+// Draw distance and fog
+extern const float VIEW_DISTANCE;
+extern const bool FOG;
+extern const float FOG_START;
+
+// Ray cast backend
+extern const int RAYCAST_BLOCK;
+
 // Falling / gravity
 extern const float GRAVITY;
 extern const float FALL_RESET_DISTANCE;
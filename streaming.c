@@ -0,0 +1,289 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include "profiler.h"
+#include "streaming.h"
+
+// Non-negative modulo for mapping chunk coordinates onto the slot window
+static int wrap(int v, int n) {
+    int m = v % n;
+    return (m < 0) ? m + n : m;
+}
+
+static Stream_Slot* slot_for(const Streamer* streamer, Cube_Key key) {
+    int sx = wrap(key.x, streamer->window);
+    int sz = wrap(key.z, streamer->window);
+    int sy = key.y - streamer->min_cy;
+    return &streamer->slots[(size_t)sx + (size_t)streamer->window * ((size_t)sz + (size_t)streamer->window * (size_t)sy)];
+}
+
+static bool same_key(Cube_Key a, Cube_Key b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// Grow a queue of chunk pointers by one slot if it's full
+static void reserve_chunk_queue(Chunk_Data*** queue, size_t count, size_t* capacity) {
+    if (count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 16;
+        *queue = (Chunk_Data**)realloc(*queue, *capacity * sizeof(Chunk_Data*));
+    }
+}
+
+// Loader thread: writes back evicted chunks first, then takes requests in order (nearest first) and
+// produces chunk data. Pending writes are always flushed before the thread exits.
+static int streamer_loader(void* data) {
+    Streamer* streamer = (Streamer*)data;
+    profiler_set_thread_name("loader");
+    SDL_LockMutex(streamer->mutex);
+    for (;;) {
+        while (!streamer->quit && streamer->request_count == 0 && streamer->write_count == 0) {
+            SDL_CondWait(streamer->cond, streamer->mutex);
+        }
+        if (streamer->write_count > 0) {
+            Chunk_Data* chunk = streamer->writes[--streamer->write_count];
+            Chunk_Sink sink = streamer->sink;
+            void* sink_data = streamer->sink_data;
+            SDL_UnlockMutex(streamer->mutex);
+            if (sink) {
+                PROFILE_BEGIN("write chunk");
+                sink(sink_data, chunk);
+                PROFILE_END();
+            }
+            free(chunk);
+            SDL_LockMutex(streamer->mutex);
+            continue;
+        }
+        if (streamer->quit) {
+            break;
+        }
+        Cube_Key key = streamer->requests[0];
+        streamer->request_count--;
+        for (size_t i = 0; i < streamer->request_count; ++i) {
+            streamer->requests[i] = streamer->requests[i + 1];
+        }
+        streamer->loading++;
+        SDL_UnlockMutex(streamer->mutex);
+
+        PROFILE_BEGIN("load chunk");
+        Chunk_Data* chunk = (Chunk_Data*)malloc(sizeof(Chunk_Data));
+        if (chunk && !streamer->source(streamer->source_data, key, chunk)) {
+            chunk->key = key;
+            chunk->cube_count = 0;
+        }
+        PROFILE_END();
+
+        SDL_LockMutex(streamer->mutex);
+        streamer->loading--;
+        if (chunk) {
+            reserve_chunk_queue(&streamer->results, streamer->result_count, &streamer->result_capacity);
+            streamer->results[streamer->result_count++] = chunk;
+        }
+    }
+    SDL_UnlockMutex(streamer->mutex);
+    return 0;
+}
+
+// Start streaming `radius` chunks around the camera, for chunk rows min_cy..max_cy
+void streamer_init(Streamer* streamer, int radius, int min_cy, int max_cy, Chunk_Source source, void* source_data) {
+    if (!streamer || !source || radius < 0 || max_cy < min_cy) {
+        printf("streamer_init(): invalid arguments. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    *streamer = (Streamer){0};
+    streamer->source = source;
+    streamer->source_data = source_data;
+    streamer->radius = radius;
+    streamer->min_cy = min_cy;
+    streamer->max_cy = max_cy;
+    // Chunks are kept until they are more than radius + 1 away, and two keys sharing a slot are always
+    // at least `window` apart, so a wanted chunk never collides with one that should still be resident.
+    streamer->window = 2 * radius + 3;
+    size_t slot_count = (size_t)streamer->window * (size_t)streamer->window * (size_t)(max_cy - min_cy + 1);
+    streamer->slots = (Stream_Slot*)calloc(slot_count, sizeof(Stream_Slot));
+    streamer->request_capacity = (size_t)STREAM_MAX_IN_FLIGHT;
+    streamer->requests = (Cube_Key*)malloc(streamer->request_capacity * sizeof(Cube_Key));
+    streamer->mutex = SDL_CreateMutex();
+    streamer->cond = SDL_CreateCond();
+    streamer->thread = SDL_CreateThread(streamer_loader, "3dsdl streamer", streamer);
+    if (!streamer->slots || !streamer->requests || !streamer->thread) {
+        printf("streamer_init(): failed to start streaming (%s). Exiting!\n", SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Have edited chunks handed to `sink` when they are evicted
+void streamer_set_sink(Streamer* streamer, Chunk_Sink sink, void* sink_data) {
+    SDL_LockMutex(streamer->mutex);
+    streamer->sink = sink;
+    streamer->sink_data = sink_data;
+    SDL_UnlockMutex(streamer->mutex);
+}
+
+// Stop the loader thread (after it has written back evicted chunks) and free everything still queued
+void streamer_shutdown(Streamer* streamer) {
+    if (!streamer || !streamer->thread) {
+        return;
+    }
+    SDL_LockMutex(streamer->mutex);
+    streamer->quit = true;
+    SDL_CondSignal(streamer->cond);
+    SDL_UnlockMutex(streamer->mutex);
+    SDL_WaitThread(streamer->thread, NULL);
+    streamer->thread = NULL;
+
+    for (size_t i = 0; i < streamer->result_count; ++i) {
+        free(streamer->results[i]);
+    }
+    free(streamer->results);
+    free(streamer->writes);
+    free(streamer->requests);
+    free(streamer->slots);
+    SDL_DestroyCond(streamer->cond);
+    SDL_DestroyMutex(streamer->mutex);
+}
+
+// Per-frame main thread step: integrate finished chunks, evict far ones and queue the nearest missing
+// ones. Work is capped by STREAM_INTEGRATE_BUDGET / STREAM_EVICT_BUDGET so the frame never blocks.
+// Returns the number of chunks integrated.
+size_t streamer_update(Streamer* streamer, World* world, Point_3D center) {
+    if (!streamer || !world) {
+        return 0;
+    }
+    Cube_Key center_cell = {
+        .x = world_to_grid_index_floor(center.x, world->step, world->offset_x),
+        .y = 0,
+        .z = world_to_grid_index_floor(center.z, world->step, world->offset_z)
+    };
+    Cube_Key center_chunk = world_chunk_key(center_cell);
+    const int keep = streamer->radius + 1;
+
+    // Take finished chunks, and pull back requests that haven't started so they can be re-prioritized
+    Chunk_Data* taken[STREAM_INTEGRATE_BUDGET];
+    size_t taken_count = 0;
+    SDL_LockMutex(streamer->mutex);
+    while (taken_count < STREAM_INTEGRATE_BUDGET && taken_count < streamer->result_count) {
+        taken[taken_count] = streamer->results[taken_count];
+        taken_count++;
+    }
+    for (size_t i = taken_count; i < streamer->result_count; ++i) {
+        streamer->results[i - taken_count] = streamer->results[i];
+    }
+    streamer->result_count -= taken_count;
+    for (size_t i = 0; i < streamer->request_count; ++i) {
+        Stream_Slot* slot = slot_for(streamer, streamer->requests[i]);
+        if (slot->state == SLOT_PENDING && same_key(slot->key, streamer->requests[i])) {
+            slot->state = SLOT_EMPTY;
+        }
+    }
+    streamer->request_count = 0;
+    int busy = streamer->loading + (int)streamer->result_count;
+    SDL_UnlockMutex(streamer->mutex);
+
+    // Integrate (results for chunks that went out of range in the meantime are dropped)
+    size_t integrated = 0;
+    for (size_t i = 0; i < taken_count; ++i) {
+        Stream_Slot* slot = slot_for(streamer, taken[i]->key);
+        if (slot->state == SLOT_PENDING && same_key(slot->key, taken[i]->key)) {
+            world_insert_chunk_data(world, taken[i]);
+            slot->state = SLOT_RESIDENT;
+            streamer->resident_count++;
+            integrated++;
+        }
+        free(taken[i]);
+    }
+
+    // Evict chunks that are now too far away
+    size_t slot_count = (size_t)streamer->window * (size_t)streamer->window * (size_t)(streamer->max_cy - streamer->min_cy + 1);
+    int evicted = 0;
+    for (size_t i = 0; i < slot_count && evicted < STREAM_EVICT_BUDGET; ++i) {
+        Stream_Slot* slot = &streamer->slots[i];
+        if (slot->state == SLOT_EMPTY) {
+            continue;
+        }
+        if (abs(slot->key.x - center_chunk.x) <= keep && abs(slot->key.z - center_chunk.z) <= keep) {
+            continue;
+        }
+        if (slot->state == SLOT_RESIDENT) {
+            // Edited chunks go to the sink (on the loader thread) before they disappear
+            const Chunk* chunk = chunk_map_get(&world->chunks, slot->key);
+            if (chunk && chunk->dirty && streamer->sink) {
+                Chunk_Data* data = (Chunk_Data*)malloc(sizeof(Chunk_Data));
+                if (data) {
+                    world_extract_chunk_data(world, slot->key, data);
+                    SDL_LockMutex(streamer->mutex);
+                    reserve_chunk_queue(&streamer->writes, streamer->write_count, &streamer->write_capacity);
+                    streamer->writes[streamer->write_count++] = data;
+                    SDL_CondSignal(streamer->cond);
+                    SDL_UnlockMutex(streamer->mutex);
+                }
+            }
+            world_remove_chunk(world, slot->key);
+            streamer->resident_count--;
+            evicted++;
+        }
+        slot->state = SLOT_EMPTY;
+    }
+
+    // Queue the missing chunks, nearest rings first
+    Cube_Key wanted[STREAM_MAX_IN_FLIGHT];
+    size_t wanted_count = 0;
+    size_t budget = (busy < STREAM_MAX_IN_FLIGHT) ? (size_t)(STREAM_MAX_IN_FLIGHT - busy) : 0;
+    for (int d = 0; d <= streamer->radius && wanted_count < budget; ++d) {
+        for (int dz = -d; dz <= d && wanted_count < budget; ++dz) {
+            for (int dx = -d; dx <= d && wanted_count < budget; ++dx) {
+                if (abs(dx) != d && abs(dz) != d) {
+                    continue;
+                }
+                for (int cy = streamer->min_cy; cy <= streamer->max_cy && wanted_count < budget; ++cy) {
+                    Cube_Key key = { .x = center_chunk.x + dx, .y = cy, .z = center_chunk.z + dz };
+                    Stream_Slot* slot = slot_for(streamer, key);
+                    if (slot->state != SLOT_EMPTY) {
+                        continue;
+                    }
+                    slot->key = key;
+                    slot->state = SLOT_PENDING;
+                    wanted[wanted_count++] = key;
+                }
+            }
+        }
+    }
+
+    if (wanted_count > 0) {
+        SDL_LockMutex(streamer->mutex);
+        for (size_t i = 0; i < wanted_count; ++i) {
+            streamer->requests[streamer->request_count++] = wanted[i];
+        }
+        SDL_CondSignal(streamer->cond);
+        SDL_UnlockMutex(streamer->mutex);
+    }
+    return integrated;
+}
+
+// Whether a chunk is currently loaded (chunks outside the streamed rows count as loaded: they are always empty)
+bool streamer_is_resident(const Streamer* streamer, Cube_Key chunk_key) {
+    if (chunk_key.y < streamer->min_cy || chunk_key.y > streamer->max_cy) {
+        return true;
+    }
+    const Stream_Slot* slot = slot_for(streamer, chunk_key);
+    return slot->state == SLOT_RESIDENT && same_key(slot->key, chunk_key);
+}
+
+// Whether a chunk and every streamed chunk below it are loaded (i.e. there's solid ground to stand on if any)
+bool streamer_column_resident(const Streamer* streamer, Cube_Key chunk_key) {
+    int top = (chunk_key.y < streamer->max_cy) ? chunk_key.y : streamer->max_cy;
+    for (int cy = streamer->min_cy; cy <= top; ++cy) {
+        if (!streamer_is_resident(streamer, (Cube_Key){ .x = chunk_key.x, .y = cy, .z = chunk_key.z })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Chunks queued or being loaded right now
+size_t streamer_in_flight(Streamer* streamer) {
+    SDL_LockMutex(streamer->mutex);
+    size_t count = streamer->request_count + (size_t)streamer->loading + streamer->result_count;
+    SDL_UnlockMutex(streamer->mutex);
+    return count;
+}
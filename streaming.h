@@ -0,0 +1,71 @@
+// streaming.h - keeps the chunks around the camera resident, loading them on a background thread
+#ifndef STREAMING_H
+#define STREAMING_H
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "data_structures.h"
+#include "world.h"
+
+// Per-frame main thread budgets, and the cap on chunks queued or loading at once
+#define STREAM_INTEGRATE_BUDGET 4
+#define STREAM_EVICT_BUDGET 2
+#define STREAM_MAX_IN_FLIGHT 32
+
+// Fills `out` with the contents of a chunk. Runs on the loader thread, so it must not touch the world.
+typedef bool (*Chunk_Source)(void* userdata, Cube_Key key, Chunk_Data* out);
+
+// Receives edited chunks as they get evicted, so changes aren't lost. Also runs on the loader thread.
+typedef void (*Chunk_Sink)(void* userdata, const Chunk_Data* data);
+
+typedef enum {
+    SLOT_EMPTY,
+    SLOT_PENDING,
+    SLOT_RESIDENT
+} Stream_Slot_State;
+
+// One chunk position of the streaming window. Slots are reused toroidally as the camera moves,
+// so `key` says which chunk currently owns the slot.
+typedef struct {
+    Cube_Key key;
+    Stream_Slot_State state;
+} Stream_Slot;
+
+typedef struct {
+    Chunk_Source source;
+    void* source_data;
+    Chunk_Sink sink;
+    void* sink_data;
+    int radius;            // chunks kept resident around the camera (horizontally)
+    int min_cy;            // vertical band of chunk rows that get streamed
+    int max_cy;
+    int window;            // slots per horizontal axis
+    Stream_Slot* slots;    // main thread only
+    size_t resident_count;
+
+    // Shared with the loader thread (guarded by mutex)
+    SDL_Thread* thread;
+    SDL_mutex* mutex;
+    SDL_cond* cond;
+    bool quit;
+    Cube_Key* requests;
+    size_t request_count;
+    size_t request_capacity;
+    Chunk_Data** results;
+    size_t result_count;
+    size_t result_capacity;
+    Chunk_Data** writes;
+    size_t write_count;
+    size_t write_capacity;
+    int loading;
+} Streamer;
+
+// Prototypes
+void streamer_init(Streamer* streamer, int radius, int min_cy, int max_cy, Chunk_Source source, void* source_data);
+void streamer_set_sink(Streamer* streamer, Chunk_Sink sink, void* sink_data);
+void streamer_shutdown(Streamer* streamer);
+size_t streamer_update(Streamer* streamer, World* world, Point_3D center);
+bool streamer_is_resident(const Streamer* streamer, Cube_Key chunk_key);
+bool streamer_column_resident(const Streamer* streamer, Cube_Key chunk_key);
+size_t streamer_in_flight(Streamer* streamer);
+
+#endif
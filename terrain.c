@@ -0,0 +1,231 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "jobs.h"
+#include "profiler.h"
+#include "terrain.h"
+
+#include <math.h>
+
+// Heightmap shape (in grid cells)
+static const float HEIGHT_SCALE = 96.0f;  // horizontal size of the largest hills
+static const int HEIGHT_MIN = 6;
+static const int HEIGHT_RANGE = 38;
+static const int SAND_LEVEL = 12;
+static const int SNOW_LEVEL = 34;
+static const int DIRT_DEPTH = 3;
+
+// Caves: carved where 3D noise exceeds the threshold
+static const float CAVE_SCALE = 14.0f;
+static const float CAVE_THRESHOLD = 0.68f;
+
+// Chunks generated per batch (bounds the size of the temporary Chunk_Data buffer)
+#define GENERATE_BATCH 256
+
+static const SDL_Color COLOR_GRASS = {86, 160, 60, 255};
+static const SDL_Color COLOR_DIRT = {121, 85, 58, 255};
+static const SDL_Color COLOR_STONE = {128, 128, 128, 255};
+static const SDL_Color COLOR_SAND = {220, 200, 120, 255};
+static const SDL_Color COLOR_SNOW = {240, 240, 250, 255};
+static const SDL_Color COLOR_BEDROCK = {50, 50, 50, 255};
+
+// Integer lattice hash -> [0, 1]. Pure function of its inputs, so the output only depends on the seed.
+static float lattice(uint32_t seed, int x, int y, int z) {
+    uint32_t h = seed * 0x9E3779B1u;
+    h ^= (uint32_t)x * 0x85EBCA77u;
+    h ^= (uint32_t)y * 0xC2B2AE3Du;
+    h ^= (uint32_t)z * 0x27D4EB2Fu;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return (float)(h & 0xFFFFFFu) / (float)0xFFFFFF;
+}
+
+static float smoothstep_weight(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static float lerpf(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+// Smoothly interpolated 2D value noise in [0, 1]
+static float value_noise_2d(uint32_t seed, float x, float z) {
+    int x0 = (int)floorf(x);
+    int z0 = (int)floorf(z);
+    float tx = smoothstep_weight(x - (float)x0);
+    float tz = smoothstep_weight(z - (float)z0);
+    float a = lerpf(lattice(seed, x0, 0, z0), lattice(seed, x0 + 1, 0, z0), tx);
+    float b = lerpf(lattice(seed, x0, 0, z0 + 1), lattice(seed, x0 + 1, 0, z0 + 1), tx);
+    return lerpf(a, b, tz);
+}
+
+// Smoothly interpolated 3D value noise in [0, 1]
+static float value_noise_3d(uint32_t seed, float x, float y, float z) {
+    int x0 = (int)floorf(x);
+    int y0 = (int)floorf(y);
+    int z0 = (int)floorf(z);
+    float tx = smoothstep_weight(x - (float)x0);
+    float ty = smoothstep_weight(y - (float)y0);
+    float tz = smoothstep_weight(z - (float)z0);
+    float c00 = lerpf(lattice(seed, x0, y0, z0), lattice(seed, x0 + 1, y0, z0), tx);
+    float c10 = lerpf(lattice(seed, x0, y0 + 1, z0), lattice(seed, x0 + 1, y0 + 1, z0), tx);
+    float c01 = lerpf(lattice(seed, x0, y0, z0 + 1), lattice(seed, x0 + 1, y0, z0 + 1), tx);
+    float c11 = lerpf(lattice(seed, x0, y0 + 1, z0 + 1), lattice(seed, x0 + 1, y0 + 1, z0 + 1), tx);
+    return lerpf(lerpf(c00, c10, ty), lerpf(c01, c11, ty), tz);
+}
+
+// Layered (fractal) 2D value noise in [0, 1], each octave twice the frequency and half the weight
+static float fbm_2d(uint32_t seed, float x, float z, int octaves) {
+    float sum = 0.0f;
+    float weight = 0.5f;
+    float total = 0.0f;
+    for (int i = 0; i < octaves; ++i) {
+        sum += value_noise_2d(seed + (uint32_t)i * 1013u, x, z) * weight;
+        total += weight;
+        x *= 2.0f;
+        z *= 2.0f;
+        weight *= 0.5f;
+    }
+    return sum / total;
+}
+
+// Height (grid y of the topmost cube) of the terrain column at grid (x, z)
+int terrain_surface_height(uint32_t seed, int x, int z) {
+    float n = fbm_2d(seed, (float)x / HEIGHT_SCALE, (float)z / HEIGHT_SCALE, 5);
+    // Flatten valleys and sharpen peaks a bit
+    float shaped = n * n * (3.0f - 2.0f * n);
+    return HEIGHT_MIN + (int)(shaped * (float)HEIGHT_RANGE);
+}
+
+static bool is_cave(uint32_t seed, int x, int y, int z) {
+    float n = value_noise_3d(seed ^ 0xCA5E5EEDu, (float)x / CAVE_SCALE, (float)y / CAVE_SCALE, (float)z / CAVE_SCALE) * 0.7f
+            + value_noise_3d(seed ^ 0x5EEDCA5Eu, (float)x / (CAVE_SCALE * 0.5f), (float)y / (CAVE_SCALE * 0.5f), (float)z / (CAVE_SCALE * 0.5f)) * 0.3f;
+    return n > CAVE_THRESHOLD;
+}
+
+// Fill one chunk of terrain. Safe to call from any thread.
+void terrain_generate_chunk(uint32_t seed, Cube_Key chunk_key, Chunk_Data* out) {
+    out->key = chunk_key;
+    out->cube_count = 0;
+    memset(out->cells, 0, sizeof(out->cells));
+
+    const int base_x = chunk_key.x * CHUNK_SIZE;
+    const int base_y = chunk_key.y * CHUNK_SIZE;
+    const int base_z = chunk_key.z * CHUNK_SIZE;
+    if (base_y > TERRAIN_TOP || base_y + CHUNK_SIZE - 1 < TERRAIN_BOTTOM) {
+        return;
+    }
+
+    for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+        for (int lx = 0; lx < CHUNK_SIZE; ++lx) {
+            int x = base_x + lx;
+            int z = base_z + lz;
+            int height = terrain_surface_height(seed, x, z);
+            for (int ly = 0; ly < CHUNK_SIZE; ++ly) {
+                int y = base_y + ly;
+                if (y < TERRAIN_BOTTOM || y > height) {
+                    continue;
+                }
+
+                SDL_Color color;
+                if (y == TERRAIN_BOTTOM) {
+                    color = COLOR_BEDROCK;
+                } else if (y < height - 1 && is_cave(seed, x, y, z)) {
+                    continue;
+                } else if (y == height) {
+                    color = (height <= SAND_LEVEL) ? COLOR_SAND : (height >= SNOW_LEVEL) ? COLOR_SNOW : COLOR_GRASS;
+                } else if (y > height - DIRT_DEPTH) {
+                    color = (height <= SAND_LEVEL) ? COLOR_SAND : COLOR_DIRT;
+                } else {
+                    color = COLOR_STONE;
+                }
+                out->cells[lx + CHUNK_SIZE * (ly + CHUNK_SIZE * lz)] = color;
+                out->cube_count++;
+            }
+        }
+    }
+}
+
+// Chunk source for streaming (see streaming.h): userdata points to the uint32_t seed
+bool terrain_chunk_source(void* userdata, Cube_Key key, Chunk_Data* out) {
+    terrain_generate_chunk(*(const uint32_t*)userdata, key, out);
+    return true;
+}
+
+typedef struct {
+    uint32_t seed;
+    const Cube_Key* keys;
+    Chunk_Data* data;
+} Generate_Job;
+
+static void generate_chunk_job(void* userdata, size_t index, int worker) {
+    (void)worker;
+    Generate_Job* job = (Generate_Job*)userdata;
+    PROFILE_BEGIN("generate chunk");
+    terrain_generate_chunk(job->seed, job->keys[index], &job->data[index]);
+    PROFILE_END();
+}
+
+// Generate every chunk within `radius` chunks (horizontally) of the origin into the world.
+// Chunks are generated in parallel, then inserted in a fixed order so the result only depends on the seed.
+size_t terrain_generate_area(World* world, uint32_t seed, int radius) {
+    if (!world || radius < 0) {
+        return 0;
+    }
+    const int min_cy = TERRAIN_BOTTOM / CHUNK_SIZE;
+    const int max_cy = TERRAIN_TOP / CHUNK_SIZE;
+    const size_t side = (size_t)(2 * radius + 1);
+    const size_t total = side * side * (size_t)(max_cy - min_cy + 1);
+
+    Cube_Key* keys = (Cube_Key*)malloc(total * sizeof(Cube_Key));
+    size_t n = 0;
+    for (int cz = -radius; cz <= radius; ++cz) {
+        for (int cx = -radius; cx <= radius; ++cx) {
+            for (int cy = min_cy; cy <= max_cy; ++cy) {
+                keys[n++] = (Cube_Key){ .x = cx, .y = cy, .z = cz };
+            }
+        }
+    }
+
+    Chunk_Data* data = (Chunk_Data*)malloc(GENERATE_BATCH * sizeof(Chunk_Data));
+    if (!keys || !data) {
+        printf("terrain_generate_area(): out of memory. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 generate_ticks = 0;
+    Uint64 insert_ticks = 0;
+    size_t cube_count = 0;
+    for (size_t first = 0; first < total; first += GENERATE_BATCH) {
+        size_t batch = (total - first < GENERATE_BATCH) ? (total - first) : GENERATE_BATCH;
+        Generate_Job job = { .seed = seed, .keys = keys + first, .data = data };
+
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        jobs_parallel_for(batch, generate_chunk_job, &job);
+        Uint64 t1 = SDL_GetPerformanceCounter();
+        for (size_t i = 0; i < batch; ++i) {
+            world_insert_chunk_data(world, &data[i]);
+            cube_count += data[i].cube_count;
+        }
+        Uint64 t2 = SDL_GetPerformanceCounter();
+        generate_ticks += t1 - t0;
+        insert_ticks += t2 - t1;
+    }
+
+    double generate_ms = (double)generate_ticks * 1000.0 / (double)freq;
+    double insert_ms = (double)insert_ticks * 1000.0 / (double)freq;
+    printf("Terrain (seed %u): %zu chunks, %zu cubes generated in %.1f ms on %d threads (%.0f chunks/s), inserted in %.1f ms\n",
+           seed, total, cube_count, generate_ms, jobs_thread_count() + 1,
+           generate_ms > 0.0 ? (double)total * 1000.0 / generate_ms : 0.0, insert_ms);
+
+    free(data);
+    free(keys);
+    return total;
+}
@@ -0,0 +1,18 @@
+// terrain.h - seedable procedural terrain generator for 3dsdl
+#ifndef TERRAIN_H
+#define TERRAIN_H
+#include <stdint.h>
+#include "data_structures.h"
+#include "world.h"
+
+// Vertical extent of generated terrain, in grid cells
+#define TERRAIN_BOTTOM 0
+#define TERRAIN_TOP 47
+
+// Prototypes
+int terrain_surface_height(uint32_t seed, int x, int z);
+void terrain_generate_chunk(uint32_t seed, Cube_Key chunk_key, Chunk_Data* out);
+size_t terrain_generate_area(World* world, uint32_t seed, int radius);
+bool terrain_chunk_source(void* userdata, Cube_Key key, Chunk_Data* out);
+
+#endif
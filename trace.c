@@ -0,0 +1,209 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "profiler.h"
+#include "trace.h"
+
+// A captured scope and the profiler lane (thread) it came from
+typedef struct {
+    Profile_Event event;
+    int thread;
+} Trace_Event;
+
+// Start of one captured frame
+typedef struct {
+    Uint64 start;
+    uint32_t number;
+} Trace_Frame;
+
+// Everything the writer thread needs, handed over when a capture ends
+typedef struct {
+    char path[1024];
+    Trace_Event* events;
+    size_t event_count;
+    Trace_Frame* frames;
+    size_t frame_count;
+    char thread_names[PROFILE_MAX_THREADS][32];
+    int thread_count;
+    Uint64 origin;
+    double ticks_per_us;
+    size_t dropped;
+} Trace_Job;
+
+static struct {
+    bool active;
+    Uint64 end;
+    unsigned cursors[PROFILE_MAX_THREADS];
+    Trace_Job* job;
+    size_t event_capacity;
+    size_t frame_capacity;
+    SDL_Thread* writer;
+    SDL_atomic_t writing;
+} capture;
+
+static Profile_Event drain_buffer[PROFILE_RING_SIZE];
+
+static void* grow(void* memory, size_t* capacity, size_t count, size_t item_size) {
+    if (count < *capacity) {
+        return memory;
+    }
+    *capacity = *capacity ? *capacity * 2 : 4096;
+    memory = realloc(memory, *capacity * item_size);
+    if (!memory) {
+        printf("grow(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Write a string as a JSON string literal
+static void write_json_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc((unsigned char)*c < 0x20 ? ' ' : *c, file);
+    }
+    fputc('"', file);
+}
+
+// Writer thread: formats the whole capture as trace_event JSON, then frees it
+static int trace_writer(void* data) {
+    Trace_Job* job = (Trace_Job*)data;
+    FILE* file = fopen(job->path, "w");
+    if (!file) {
+        printf("Could not write trace %s\n", job->path);
+    } else {
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"3dsdl\"}}");
+        for (int t = 0; t < job->thread_count; ++t) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", t);
+            write_json_string(file, job->thread_names[t]);
+            fprintf(file, "}}");
+        }
+        // Frame starts as global instant events, so frames line up across all threads
+        for (size_t i = 0; i < job->frame_count; ++i) {
+            double ts = (double)(job->frames[i].start - job->origin) / job->ticks_per_us;
+            fprintf(file, ",\n{\"name\":\"frame %u\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+                (unsigned)job->frames[i].number, ts);
+        }
+        // Complete ("X") events for every scope
+        for (size_t i = 0; i < job->event_count; ++i) {
+            const Trace_Event* traced = &job->events[i];
+            double ts = (double)(traced->event.start - job->origin) / job->ticks_per_us;
+            double dur = (double)(traced->event.end - traced->event.start) / job->ticks_per_us;
+            fprintf(file, ",\n{\"name\":");
+            write_json_string(file, traced->event.name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                traced->thread, ts, dur, (unsigned)traced->event.frame);
+        }
+        fprintf(file, "\n]}\n");
+        if (fclose(file) == 0) {
+            printf("Trace written to %s (%zu scopes, %zu frames", job->path, job->event_count, job->frame_count);
+            if (job->dropped > 0) {
+                printf(", %zu scopes lost to ring buffer overflow", job->dropped);
+            }
+            printf(")\n");
+        } else {
+            printf("Could not write trace %s\n", job->path);
+        }
+    }
+    free(job->events);
+    free(job->frames);
+    free(job);
+    SDL_AtomicSet(&capture.writing, 0);
+    return 0;
+}
+
+// Start capturing profiler scopes for `seconds`, written to `path` when done. Returns false if a capture
+// (or the writing of the previous one) is still in progress.
+bool trace_capture_start(const char* path, float seconds) {
+    if (capture.active || SDL_AtomicGet(&capture.writing)) {
+        printf("A trace capture is already in progress\n");
+        return false;
+    }
+    if (capture.writer) {
+        SDL_WaitThread(capture.writer, NULL);
+        capture.writer = NULL;
+    }
+    capture.job = (Trace_Job*)calloc(1, sizeof(Trace_Job));
+    if (!capture.job) {
+        printf("trace_capture_start(): Memory allocation failed. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(capture.job->path, sizeof(capture.job->path), "%s", path);
+    capture.job->origin = SDL_GetPerformanceCounter();
+    capture.job->ticks_per_us = (double)SDL_GetPerformanceFrequency() / 1e6;
+    capture.event_capacity = 0;
+    capture.frame_capacity = 0;
+    for (int t = 0; t < PROFILE_MAX_THREADS; ++t) {
+        capture.cursors[t] = profiler_cursor(t);
+    }
+    capture.end = capture.job->origin + (Uint64)((double)seconds * (double)SDL_GetPerformanceFrequency());
+    capture.active = true;
+    printf("Capturing a %.1f s trace to %s\n", seconds, path);
+    return true;
+}
+
+// Hand the finished capture to the writer thread
+static void finish_capture(void) {
+    Trace_Job* job = capture.job;
+    job->thread_count = profiler_thread_count();
+    for (int t = 0; t < job->thread_count; ++t) {
+        snprintf(job->thread_names[t], sizeof(job->thread_names[t]), "%s", profiler_thread_name(t));
+    }
+    capture.active = false;
+    capture.job = NULL;
+    SDL_AtomicSet(&capture.writing, 1);
+    capture.writer = SDL_CreateThread(trace_writer, "3dsdl trace", job);
+    if (!capture.writer) {
+        printf("finish_capture(): SDL_CreateThread Error: %s, writing the trace on this thread\n", SDL_GetError());
+        trace_writer(job);
+    }
+}
+
+// Per-frame step (main thread, right after profiler_begin_frame()): collect the scopes recorded since the
+// last frame, and finish the capture once its time is up
+void trace_capture_frame(void) {
+    if (!capture.active) {
+        return;
+    }
+    Trace_Job* job = capture.job;
+    uint32_t frame = profiler_frame();
+    job->frames = (Trace_Frame*)grow(job->frames, &capture.frame_capacity, job->frame_count, sizeof(Trace_Frame));
+    job->frames[job->frame_count++] = (Trace_Frame){ .start = profiler_frame_start(frame), .number = frame };
+
+    for (int t = 0; t < profiler_thread_count(); ++t) {
+        size_t count = profiler_drain(t, &capture.cursors[t], drain_buffer, PROFILE_RING_SIZE, &job->dropped);
+        for (size_t i = 0; i < count; ++i) {
+            if (drain_buffer[i].start < job->origin) {
+                continue; // opened before the capture started
+            }
+            job->events = (Trace_Event*)grow(job->events, &capture.event_capacity, job->event_count, sizeof(Trace_Event));
+            job->events[job->event_count++] = (Trace_Event){ .event = drain_buffer[i], .thread = t };
+        }
+    }
+
+    if (profiler_frame_start(frame) >= capture.end) {
+        finish_capture();
+    }
+}
+
+bool trace_capture_active(void) {
+    return capture.active;
+}
+
+// Finish any capture in progress and wait for the writer
+void trace_shutdown(void) {
+    if (capture.active) {
+        finish_capture();
+    }
+    if (capture.writer) {
+        SDL_WaitThread(capture.writer, NULL);
+        capture.writer = NULL;
+    }
+}
@@ -0,0 +1,12 @@
+// trace.h - captures profiler scopes to Chrome trace_event JSON (chrome://tracing, Perfetto) for 3dsdl
+#ifndef TRACE_H
+#define TRACE_H
+#include <stdbool.h>
+
+// Prototypes
+bool trace_capture_start(const char* path, float seconds);
+void trace_capture_frame(void);
+bool trace_capture_active(void);
+void trace_shutdown(void);
+
+#endif
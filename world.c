@@ -0,0 +1,782 @@
+#include <float.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "jobs.h"
+#include "profiler.h"
+#include "settings.h"
+#include "world.h"
+
+#include <math.h>
+
+// Initialize an empty world (capacity will be rounded up to next power of 2)
+void init_world(World* world, size_t initial_capacity, float step, float offset_x, float offset_y, float offset_z) {
+    if (!world) {
+        printf("init_world(): NULL world pointer. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    init_cube_map(&world->cubes, initial_capacity);
+    init_chunk_map(&world->chunks, initial_capacity / (CHUNK_SIZE * CHUNK_SIZE) + 1);
+    world->revision = 0;
+    world->step = step;
+    world->offset_x = offset_x;
+    world->offset_y = offset_y;
+    world->offset_z = offset_z;
+}
+
+// Free the world's cubes and chunks
+void free_world(World* world) {
+    if (!world) {
+        return;
+    }
+    free_cube_map(&world->cubes);
+    free_chunk_map(&world->chunks);
+}
+
+// Cube corner indices of each face (see make_cube) and the grid direction that face points to.
+static const int FACE_INDICES[6][4] = {
+    {0, 1, 2, 3},
+    {4, 5, 6, 7},
+    {0, 1, 5, 4},
+    {2, 3, 7, 6},
+    {1, 2, 6, 5},
+    {0, 3, 7, 4}
+};
+static const int FACE_NORMALS[6][3] = {
+    {0, 0, -1},
+    {0, 0, 1},
+    {0, -1, 0},
+    {0, 1, 0},
+    {1, 0, 0},
+    {-1, 0, 0}
+};
+
+// Directional shading: how much light each face direction gets, brightest from above
+static const float FACE_SHADES[6] = { 0.7f, 0.7f, 0.5f, 1.0f, 0.85f, 0.85f };
+
+// Floor division by CHUNK_SIZE (plain '/' rounds towards zero for negative coordinates)
+static int chunk_coord(int v) {
+    return (v >= 0) ? (v / CHUNK_SIZE) : -((-v + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+// Chunk coordinates of the chunk containing the given grid cell
+Cube_Key world_chunk_key(Cube_Key cell) {
+    Cube_Key key = {
+        .x = chunk_coord(cell.x),
+        .y = chunk_coord(cell.y),
+        .z = chunk_coord(cell.z)
+    };
+    return key;
+}
+
+// Mark the mesh of the chunk at the given chunk coordinates for rebuilding (no-op if it doesn't exist)
+static void invalidate_chunk(World* world, int cx, int cy, int cz) {
+    Chunk* chunk = chunk_map_get(&world->chunks, (Cube_Key){ .x = cx, .y = cy, .z = cz });
+    if (chunk) {
+        chunk->mesh_dirty = true;
+    }
+}
+
+// Invalidate the meshes of the 26 chunks around the given chunk (the ones sharing only an edge or a corner
+// with it included, for their ambient occlusion)
+static void invalidate_neighbour_chunks(World* world, Cube_Key chunk_key) {
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dx != 0 || dy != 0 || dz != 0) {
+                    invalidate_chunk(world, chunk_key.x + dx, chunk_key.y + dy, chunk_key.z + dz);
+                }
+            }
+        }
+    }
+}
+
+// Invalidate the meshes that can change with the given cell: the chunks holding it or any of its 26
+// neighbouring cells, whose faces it can hide or shade (ambient occlusion). That's its own chunk, plus the
+// chunks across the borders it touches.
+void world_invalidate_cell(World* world, Cube_Key key) {
+    if (!world) {
+        return;
+    }
+    Cube_Key low = world_chunk_key((Cube_Key){ .x = key.x - 1, .y = key.y - 1, .z = key.z - 1 });
+    Cube_Key high = world_chunk_key((Cube_Key){ .x = key.x + 1, .y = key.y + 1, .z = key.z + 1 });
+    for (int cz = low.z; cz <= high.z; ++cz) {
+        for (int cy = low.y; cy <= high.y; ++cy) {
+            for (int cx = low.x; cx <= high.x; ++cx) {
+                invalidate_chunk(world, cx, cy, cz);
+            }
+        }
+    }
+}
+
+// Add a cube (from cube_map_new_cube() on world->cubes) to the world, replacing (and freeing) any cube already
+// stored at that key
+bool world_add_cube(World* world, Cube_Key key, Cube* cube) {
+    if (!world || !cube) {
+        printf("world_add_cube(): NULL pointer. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (cube_map_get(&world->cubes, key)) {
+        cube_map_remove(&world->cubes, key);
+    } else {
+        Cube_Key chunk_key = world_chunk_key(key);
+        Chunk* chunk = chunk_map_get(&world->chunks, chunk_key);
+        if (!chunk) {
+            chunk = (Chunk*)calloc(1, sizeof(Chunk));
+            chunk->key = chunk_key;
+            chunk->mesh_dirty = true;
+            chunk_map_add(&world->chunks, chunk_key, chunk);
+        }
+        chunk->cube_count++;
+    }
+    chunk_map_get(&world->chunks, world_chunk_key(key))->dirty = true;
+    bool added = cube_map_add(&world->cubes, key, cube);
+    world_invalidate_cell(world, key);
+    world->revision++;
+    return added;
+}
+
+// Remove (and free) the cube at the given key. Its chunk is kept even once empty, so the edit can still be saved.
+bool world_remove_cube(World* world, Cube_Key key) {
+    if (!world || !cube_map_remove(&world->cubes, key)) {
+        return false;
+    }
+    world_invalidate_cell(world, key);
+    world->revision++;
+    Chunk* chunk = chunk_map_get(&world->chunks, world_chunk_key(key));
+    if (chunk) {
+        chunk->cube_count--;
+        chunk->dirty = true;
+    }
+    return true;
+}
+
+// Create a cube of the given color at a grid cell and add it to the world
+Cube* world_place_cube(World* world, Cube_Key key, SDL_Color color) {
+    if (!world) {
+        printf("world_place_cube(): NULL world pointer. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    Cube* cube = cube_map_new_cube(&world->cubes);
+    make_cube(cube, world->step, world_cell_center(world, key), color);
+    world_add_cube(world, key, cube);
+    return cube;
+}
+
+// World space bounds of a grid cell
+AABB world_cell_aabb(const World* world, Cube_Key key) {
+    Point_3D center = world_cell_center(world, key);
+    float half = world->step * 0.5f;
+    AABB box = {
+        .min_x = center.x - half,
+        .max_x = center.x + half,
+        .min_y = center.y - half,
+        .max_y = center.y + half,
+        .min_z = center.z - half,
+        .max_z = center.z + half
+    };
+    return box;
+}
+
+// Append a face to a growable face array
+static Chunk_Face* push_face(Chunk_Face** faces, size_t* count, size_t* capacity) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 64;
+        *faces = (Chunk_Face*)realloc(*faces, *capacity * sizeof(Chunk_Face));
+        if (!*faces) {
+            printf("push_face(): Memory allocation failed. Exiting!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return &(*faces)[(*count)++];
+}
+
+static bool same_color(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+// Merge 2x2x2 cells (alpha 0 = empty) into one: solid when at least half of them are, in their most common color
+static SDL_Color merge_cells(const SDL_Color cells[8]) {
+    SDL_Color merged = { 0, 0, 0, 0 };
+    int solid = 0;
+    int best_votes = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (cells[i].a == 0) {
+            continue;
+        }
+        solid++;
+        int votes = 0;
+        for (int j = i; j < 8; ++j) {
+            votes += same_color(cells[i], cells[j]) ? 1 : 0;
+        }
+        if (votes > best_votes) {
+            best_votes = votes;
+            merged = cells[i];
+        }
+    }
+    return solid >= 4 ? merged : (SDL_Color){ 0, 0, 0, 0 };
+}
+
+// A cell of the given level of detail straight from the cube map. Level n cells are 2^n cubes wide and keyed
+// in their own grid, so cell k spans cubes k * 2^n to (k + 1) * 2^n - 1.
+static SDL_Color sample_lod_cell(const World* world, Cube_Key key, int level) {
+    if (level == 0) {
+        const Cube* cube = cube_map_get(&world->cubes, key);
+        return cube ? cube->color : (SDL_Color){ 0, 0, 0, 0 };
+    }
+    SDL_Color children[8];
+    for (int i = 0; i < 8; ++i) {
+        Cube_Key child = { .x = key.x * 2 + (i & 1), .y = key.y * 2 + ((i >> 1) & 1), .z = key.z * 2 + ((i >> 2) & 1) };
+        children[i] = sample_lod_cell(world, child, level - 1);
+    }
+    return merge_cells(children);
+}
+
+// The cells a mesh level is built from: one chunk's dense size^3 cells of that level, for the AO occlusion
+// lookups of light_face. Beyond them, full detail reads the cube map, while coarser levels see open space:
+// their faces are far away, and a merged cell costs up to 73 cube lookups. Face culling still samples the
+// neighbours across the border.
+typedef struct {
+    const World* world;
+    const SDL_Color* cells;
+    int size;
+    int level;
+    Cube_Key base;  // key of cells[0] in the level's grid
+} Mesh_Cells;
+
+static bool mesh_cell_solid(const Mesh_Cells* mesh, Cube_Key key) {
+    int x = key.x - mesh->base.x;
+    int y = key.y - mesh->base.y;
+    int z = key.z - mesh->base.z;
+    if (x >= 0 && x < mesh->size && y >= 0 && y < mesh->size && z >= 0 && z < mesh->size) {
+        return mesh->cells[x + mesh->size * (y + mesh->size * z)].a != 0;
+    }
+    return mesh->level == 0 && cube_map_get(&mesh->world->cubes, key) != NULL;
+}
+
+// Bake the lighting of a face of the cell at `key` (centered at `center`) into its corner colors: the face
+// direction's shade, times ambient occlusion from the three cells in front of the face around each corner
+// (the two sides and the diagonal, with both sides solid counting as fully occluded)
+static void light_face(const Mesh_Cells* mesh, Cube_Key key, int fi, Point_3D center, SDL_Color color, Chunk_Face* face) {
+    const int* normal = FACE_NORMALS[fi];
+    const int axis = normal[0] != 0 ? 0 : normal[1] != 0 ? 1 : 2;
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    const int cell[3] = { key.x, key.y, key.z };
+    for (int pi = 0; pi < 4; ++pi) {
+        if (!VOXEL_LIGHTING) {
+            face->lit[pi] = color;
+            continue;
+        }
+        // Step from the cell towards the corner, through the face
+        const Point_3D* p = &face->points[pi];
+        int d[3] = { p->x > center.x ? 1 : -1, p->y > center.y ? 1 : -1, p->z > center.z ? 1 : -1 };
+        d[axis] = normal[axis];
+        int corner[3];
+        int side_u[3];
+        int side_v[3];
+        for (int a = 0; a < 3; ++a) {
+            corner[a] = cell[a] + d[a];
+            side_u[a] = cell[a] + (a == v ? 0 : d[a]);
+            side_v[a] = cell[a] + (a == u ? 0 : d[a]);
+        }
+        bool solid_u = mesh_cell_solid(mesh, (Cube_Key){ .x = side_u[0], .y = side_u[1], .z = side_u[2] });
+        bool solid_v = mesh_cell_solid(mesh, (Cube_Key){ .x = side_v[0], .y = side_v[1], .z = side_v[2] });
+        int occlusion = 3;
+        if (!solid_u || !solid_v) {
+            occlusion = (solid_u ? 1 : 0) + (solid_v ? 1 : 0) +
+                        (mesh_cell_solid(mesh, (Cube_Key){ .x = corner[0], .y = corner[1], .z = corner[2] }) ? 1 : 0);
+        }
+        float light = FACE_SHADES[fi] * (1.0f - AO_STRENGTH * (float)occlusion / 3.0f);
+        face->lit[pi] = (SDL_Color){ (Uint8)(color.r * light), (Uint8)(color.g * light), (Uint8)(color.b * light), color.a };
+    }
+}
+
+// Mesh one coarse level of a chunk from its dense size^3 cells: one face per merged cube side facing an empty
+// cell of the same level. Neighbours across the chunk border are sampled from the world.
+static void mesh_chunk_lod(const World* world, Chunk* chunk, int level, const SDL_Color* cells, int size) {
+    Chunk_Lod* lod = &chunk->lods[level - 1];
+    lod->face_count = 0;
+    const int span = 1 << level;
+    const float half_span = (float)(span - 1) * world->step * 0.5f;
+    const Mesh_Cells mesh = {
+        .world = world, .cells = cells, .size = size, .level = level,
+        .base = { .x = chunk->key.x * size, .y = chunk->key.y * size, .z = chunk->key.z * size }
+    };
+    for (int z = 0; z < size; ++z) {
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                SDL_Color color = cells[x + size * (y + size * z)];
+                if (color.a == 0) {
+                    continue;
+                }
+                Cube_Key key = { .x = chunk->key.x * size + x, .y = chunk->key.y * size + y, .z = chunk->key.z * size + z };
+                Cube merged;
+                Point_3D center;
+                bool built = false;
+                for (int fi = 0; fi < 6; ++fi) {
+                    int nx = x + FACE_NORMALS[fi][0];
+                    int ny = y + FACE_NORMALS[fi][1];
+                    int nz = z + FACE_NORMALS[fi][2];
+                    SDL_Color neighbour;
+                    if (nx >= 0 && nx < size && ny >= 0 && ny < size && nz >= 0 && nz < size) {
+                        neighbour = cells[nx + size * (ny + size * nz)];
+                    } else {
+                        Cube_Key outside = { .x = key.x + FACE_NORMALS[fi][0], .y = key.y + FACE_NORMALS[fi][1], .z = key.z + FACE_NORMALS[fi][2] };
+                        neighbour = sample_lod_cell(world, outside, level);
+                    }
+                    if (neighbour.a != 0) {
+                        continue;
+                    }
+                    if (!built) {
+                        center = world_cell_center(world, (Cube_Key){ .x = key.x * span, .y = key.y * span, .z = key.z * span });
+                        center.x += half_span;
+                        center.y += half_span;
+                        center.z += half_span;
+                        make_cube(&merged, world->step * (float)span, center, color);
+                        built = true;
+                    }
+                    Chunk_Face* face = push_face(&lod->faces, &lod->face_count, &lod->face_capacity);
+                    for (int pi = 0; pi < 4; ++pi) {
+                        face->points[pi] = merged.points[FACE_INDICES[fi][pi]];
+                    }
+                    face->color = color;
+                    face->dir = fi;
+                    light_face(&mesh, key, fi, center, color, face);
+                }
+            }
+        }
+    }
+}
+
+// Rebuild the coarse levels of a chunk's mesh from its dense cells, as a voxel mip chain: every level merges
+// 2x2x2 cells of the one below it (see merge_cells).
+static void mesh_chunk_lods(const World* world, Chunk* chunk, const SDL_Color cells[CHUNK_VOLUME]) {
+    SDL_Color fine[CHUNK_VOLUME];
+    SDL_Color coarse[CHUNK_VOLUME / 8];
+    memcpy(fine, cells, sizeof(fine));
+
+    int size = CHUNK_SIZE;
+    for (int level = 1; level < CHUNK_LOD_LEVELS; ++level) {
+        const int half = size / 2;
+        for (int z = 0; z < half; ++z) {
+            for (int y = 0; y < half; ++y) {
+                for (int x = 0; x < half; ++x) {
+                    SDL_Color children[8];
+                    for (int i = 0; i < 8; ++i) {
+                        int cx = x * 2 + (i & 1);
+                        int cy = y * 2 + ((i >> 1) & 1);
+                        int cz = z * 2 + ((i >> 2) & 1);
+                        children[i] = fine[cx + size * (cy + size * cz)];
+                    }
+                    coarse[x + half * (y + half * z)] = merge_cells(children);
+                }
+            }
+        }
+        size = half;
+        mesh_chunk_lod(world, chunk, level, coarse, size);
+        memcpy(fine, coarse, (size_t)size * size * size * sizeof(SDL_Color));
+    }
+}
+
+// Rebuild the cached mesh of a chunk: one face per cube side that isn't covered by a neighbouring cube, with
+// its lighting baked into the corner colors (see light_face), plus the coarser levels of detail.
+void world_mesh_chunk(const World* world, Chunk* chunk) {
+    if (!world || !chunk) {
+        return;
+    }
+    chunk->face_count = 0;
+    const int base_x = chunk->key.x * CHUNK_SIZE;
+    const int base_y = chunk->key.y * CHUNK_SIZE;
+    const int base_z = chunk->key.z * CHUNK_SIZE;
+
+    // The chunk's cells in dense form, for the occlusion lookups and the coarser levels
+    SDL_Color cells[CHUNK_VOLUME];
+    size_t index = 0;
+    for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+        for (int ly = 0; ly < CHUNK_SIZE; ++ly) {
+            for (int lx = 0; lx < CHUNK_SIZE; ++lx, ++index) {
+                Cube_Key key = { .x = base_x + lx, .y = base_y + ly, .z = base_z + lz };
+                const Cube* cube = cube_map_get(&world->cubes, key);
+                cells[index] = cube ? cube->color : (SDL_Color){ 0, 0, 0, 0 };
+            }
+        }
+    }
+    const Mesh_Cells mesh = { .world = world, .cells = cells, .size = CHUNK_SIZE, .level = 0, .base = { .x = base_x, .y = base_y, .z = base_z } };
+
+    for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+        for (int ly = 0; ly < CHUNK_SIZE; ++ly) {
+            for (int lx = 0; lx < CHUNK_SIZE; ++lx) {
+                Cube_Key key = { .x = base_x + lx, .y = base_y + ly, .z = base_z + lz };
+                const Cube* cube = cube_map_get(&world->cubes, key);
+                if (!cube) {
+                    continue;
+                }
+
+                // Face mask: a side is only visible when the cell it faces is empty
+                int mask = 0;
+                for (int fi = 0; fi < 6; ++fi) {
+                    Cube_Key neighbour = {
+                        .x = key.x + FACE_NORMALS[fi][0],
+                        .y = key.y + FACE_NORMALS[fi][1],
+                        .z = key.z + FACE_NORMALS[fi][2]
+                    };
+                    if (!cube_map_get(&world->cubes, neighbour)) {
+                        mask |= 1 << fi;
+                    }
+                }
+                if (mask == 0) {
+                    continue;
+                }
+
+                for (int fi = 0; fi < 6; ++fi) {
+                    if (!(mask & (1 << fi))) {
+                        continue;
+                    }
+                    Chunk_Face* face = push_face(&chunk->faces, &chunk->face_count, &chunk->face_capacity);
+                    for (int pi = 0; pi < 4; ++pi) {
+                        face->points[pi] = cube->points[FACE_INDICES[fi][pi]];
+                    }
+                    face->color = cube->color;
+                    face->dir = fi;
+                    light_face(&mesh, key, fi, world_cell_center(world, key), cube->color, face);
+                }
+            }
+        }
+    }
+    mesh_chunk_lods(world, chunk, cells);
+    chunk->mesh_dirty = false;
+}
+
+// Directional shade of a face pointing along the given grid normal (1 with lighting off)
+float world_face_shade(int normal_x, int normal_y, int normal_z) {
+    if (!VOXEL_LIGHTING) {
+        return 1.0f;
+    }
+    for (int fi = 0; fi < 6; ++fi) {
+        if (FACE_NORMALS[fi][0] == normal_x && FACE_NORMALS[fi][1] == normal_y && FACE_NORMALS[fi][2] == normal_z) {
+            return FACE_SHADES[fi];
+        }
+    }
+    return 1.0f;
+}
+
+// The faces of a chunk's mesh at a level of detail (0 = full detail)
+const Chunk_Face* world_chunk_mesh(const Chunk* chunk, int level, size_t* face_count) {
+    if (level <= 0 || level >= CHUNK_LOD_LEVELS) {
+        *face_count = chunk->face_count;
+        return chunk->faces;
+    }
+    *face_count = chunk->lods[level - 1].face_count;
+    return chunk->lods[level - 1].faces;
+}
+
+// Backface test: whether `eye` is on the outer side of a (axis-aligned) mesh face
+bool world_face_visible(const Chunk_Face* face, Point_3D eye) {
+    const Point_3D* p = &face->points[0];
+    switch (face->dir) {
+    case 0: return eye.z < p->z;
+    case 1: return eye.z > p->z;
+    case 2: return eye.y < p->y;
+    case 3: return eye.y > p->y;
+    case 4: return eye.x > p->x;
+    case 5: return eye.x < p->x;
+    default: return true;
+    }
+}
+
+// Retrieve a cube from the world by its grid key (NULL if empty)
+Cube* world_get_cube(const World* world, Cube_Key key) {
+    return world ? cube_map_get(&world->cubes, key) : NULL;
+}
+
+// World space center of a grid cell
+Point_3D world_cell_center(const World* world, Cube_Key key) {
+    Point_3D center = {
+        .x = key.x * world->step - world->offset_x,
+        .y = key.y * world->step - world->offset_y,
+        .z = key.z * world->step - world->offset_z
+    };
+    return center;
+}
+
+// Distance along the ray (from the origin) at which it leaves `cell` on one axis.
+// `u` is the origin in grid units, cell boundaries sit at integer grid coordinates.
+static float ray_axis_exit(float u, float d, int cell, int span, float step) {
+    if (d > 0.0f) {
+        return ((float)(cell + span) - u) * step / d;
+    }
+    if (d < 0.0f) {
+        return (u - (float)cell) * step / -d;
+    }
+    return FLT_MAX;
+}
+
+// Insert a whole chunk's worth of cubes at once. The chunk must not hold any cubes yet.
+void world_insert_chunk_data(World* world, const Chunk_Data* data) {
+    if (!world || !data) {
+        printf("world_insert_chunk_data(): NULL pointer. Exiting!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (data->cube_count == 0) {
+        return;
+    }
+    Chunk* chunk = chunk_map_get(&world->chunks, data->key);
+    if (!chunk) {
+        chunk = (Chunk*)calloc(1, sizeof(Chunk));
+        chunk->key = data->key;
+        chunk_map_add(&world->chunks, data->key, chunk);
+    }
+
+    const int base_x = data->key.x * CHUNK_SIZE;
+    const int base_y = data->key.y * CHUNK_SIZE;
+    const int base_z = data->key.z * CHUNK_SIZE;
+    size_t index = 0;
+    for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+        for (int ly = 0; ly < CHUNK_SIZE; ++ly) {
+            for (int lx = 0; lx < CHUNK_SIZE; ++lx, ++index) {
+                SDL_Color color = data->cells[index];
+                if (color.a == 0) {
+                    continue;
+                }
+                Cube_Key key = { .x = base_x + lx, .y = base_y + ly, .z = base_z + lz };
+                Cube* cube = cube_map_new_cube(&world->cubes);
+                make_cube(cube, world->step, world_cell_center(world, key), color);
+                cube_map_add(&world->cubes, key, cube);
+                chunk->cube_count++;
+            }
+        }
+    }
+
+    // The new cubes can hide (or shade) faces of the neighbours
+    chunk->mesh_dirty = true;
+    invalidate_neighbour_chunks(world, data->key);
+    world->revision++;
+}
+
+// Copy the contents of a chunk into dense form (all empty if the chunk isn't loaded)
+void world_extract_chunk_data(const World* world, Cube_Key chunk_key, Chunk_Data* out) {
+    out->key = chunk_key;
+    out->cube_count = 0;
+    memset(out->cells, 0, sizeof(out->cells));
+    const Chunk* chunk = world ? chunk_map_get(&world->chunks, chunk_key) : NULL;
+    if (!chunk) {
+        return;
+    }
+
+    const int base_x = chunk_key.x * CHUNK_SIZE;
+    const int base_y = chunk_key.y * CHUNK_SIZE;
+    const int base_z = chunk_key.z * CHUNK_SIZE;
+    size_t index = 0;
+    for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+        for (int ly = 0; ly < CHUNK_SIZE; ++ly) {
+            for (int lx = 0; lx < CHUNK_SIZE; ++lx, ++index) {
+                Cube_Key key = { .x = base_x + lx, .y = base_y + ly, .z = base_z + lz };
+                const Cube* cube = cube_map_get(&world->cubes, key);
+                if (cube) {
+                    out->cells[index] = cube->color;
+                    out->cells[index].a = 255;
+                    out->cube_count++;
+                }
+            }
+        }
+    }
+}
+
+// Remove (and free) every cube of a chunk, returns how many were removed
+size_t world_remove_chunk(World* world, Cube_Key chunk_key) {
+    if (!world) {
+        return 0;
+    }
+    Chunk* chunk = chunk_map_get(&world->chunks, chunk_key);
+    if (!chunk) {
+        return 0;
+    }
+
+    const int base_x = chunk_key.x * CHUNK_SIZE;
+    const int base_y = chunk_key.y * CHUNK_SIZE;
+    const int base_z = chunk_key.z * CHUNK_SIZE;
+    size_t removed = 0;
+    for (int lz = 0; lz < CHUNK_SIZE && removed < chunk->cube_count; ++lz) {
+        for (int ly = 0; ly < CHUNK_SIZE && removed < chunk->cube_count; ++ly) {
+            for (int lx = 0; lx < CHUNK_SIZE && removed < chunk->cube_count; ++lx) {
+                Cube_Key key = { .x = base_x + lx, .y = base_y + ly, .z = base_z + lz };
+                if (cube_map_remove(&world->cubes, key)) {
+                    removed++;
+                }
+            }
+        }
+    }
+    chunk_map_remove(&world->chunks, chunk_key);
+
+    // Faces of the neighbours that were hidden by this chunk are exposed now
+    invalidate_neighbour_chunks(world, chunk_key);
+    world->revision++;
+    return removed;
+}
+
+typedef struct {
+    const World* world;
+    Chunk** chunks;
+} Mesh_Job;
+
+static void mesh_chunk_job(void* userdata, size_t index, int worker) {
+    (void)worker;
+    Mesh_Job* job = (Mesh_Job*)userdata;
+    PROFILE_BEGIN("mesh chunk");
+    world_mesh_chunk(job->world, job->chunks[index]);
+    PROFILE_END();
+}
+
+// Rebuild every dirty chunk mesh, spread across the job pool (meshing only reads the cube map and
+// writes to its own chunk, so chunks are independent). Returns the number of chunks rebuilt.
+size_t world_mesh_dirty_chunks(World* world) {
+    if (!world) {
+        return 0;
+    }
+    size_t capacity = chunk_map_capacity(&world->chunks);
+    size_t dirty_count = 0;
+    for (size_t i = 0; i < capacity; ++i) {
+        const Chunk_Map_Entry* entry = chunk_map_entry_at(&world->chunks, i);
+        if (entry->occupied && entry->chunk && entry->chunk->mesh_dirty) {
+            dirty_count++;
+        }
+    }
+    if (dirty_count == 0) {
+        return 0;
+    }
+
+    Mesh_Job job = { .world = world, .chunks = ARENA_ALLOC_ARRAY(frame_arena(0), Chunk*, dirty_count) };
+    size_t n = 0;
+    for (size_t i = 0; i < capacity; ++i) {
+        const Chunk_Map_Entry* entry = chunk_map_entry_at(&world->chunks, i);
+        if (entry->occupied && entry->chunk && entry->chunk->mesh_dirty) {
+            job.chunks[n++] = entry->chunk;
+        }
+    }
+    jobs_parallel_for(n, mesh_chunk_job, &job);
+    return n;
+}
+
+// Amanatides-Woo grid traversal: walk the cells pierced by the ray in order and stop at the first cube.
+// Whenever the ray is inside an empty chunk it jumps straight to the chunk's exit instead of stepping
+// through its CHUNK_SIZE^3 cells, so long rays across open air only cost a few chunk lookups.
+bool world_raycast(const World* world, Point_3D origin, Point_3D dir, float max_distance, Ray_Hit* hit) {
+    Ray_Hit result = {0};
+    if (hit) {
+        *hit = result;
+    }
+    if (!world || world->cubes.size == 0) {
+        return false;
+    }
+    float len = sqrtf(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+    if (len < 0.000001f) {
+        return false;
+    }
+
+    // Work in grid units (cell k spans [k, k + 1)) with t measured in world units along the normalized ray
+    const float step = world->step;
+    const float d[3] = { dir.x / len, dir.y / len, dir.z / len };
+    const float u[3] = {
+        (origin.x + world->offset_x) / step + 0.5f,
+        (origin.y + world->offset_y) / step + 0.5f,
+        (origin.z + world->offset_z) / step + 0.5f
+    };
+    const int step_dir[3] = {
+        (d[0] > 0.0f) - (d[0] < 0.0f),
+        (d[1] > 0.0f) - (d[1] < 0.0f),
+        (d[2] > 0.0f) - (d[2] < 0.0f)
+    };
+    int cell[3] = { (int)floorf(u[0]), (int)floorf(u[1]), (int)floorf(u[2]) };
+    float t_max[3];
+    float t_delta[3];
+    for (int a = 0; a < 3; ++a) {
+        t_max[a] = ray_axis_exit(u[a], d[a], cell[a], 1, step);
+        t_delta[a] = (d[a] != 0.0f) ? step / fabsf(d[a]) : FLT_MAX;
+    }
+
+    float t = 0.0f;
+    int last_axis = -1;
+    Cube_Key cached_chunk_key = {0};
+    const Chunk* cached_chunk = NULL;
+    bool chunk_cached = false;
+
+    while (t <= max_distance) {
+        Cube_Key key = { .x = cell[0], .y = cell[1], .z = cell[2] };
+        Cube_Key chunk_key = world_chunk_key(key);
+        if (!chunk_cached || chunk_key.x != cached_chunk_key.x || chunk_key.y != cached_chunk_key.y || chunk_key.z != cached_chunk_key.z) {
+            cached_chunk = chunk_map_get(&world->chunks, chunk_key);
+            cached_chunk_key = chunk_key;
+            chunk_cached = true;
+        }
+
+        if (!cached_chunk || cached_chunk->cube_count == 0) {
+            // Empty chunk: leave it in one step through whichever of its faces the ray exits first
+            const int chunk_min[3] = { chunk_key.x * CHUNK_SIZE, chunk_key.y * CHUNK_SIZE, chunk_key.z * CHUNK_SIZE };
+            float t_exit = FLT_MAX;
+            int exit_axis = 0;
+            for (int a = 0; a < 3; ++a) {
+                float ta = ray_axis_exit(u[a], d[a], chunk_min[a], CHUNK_SIZE, step);
+                if (ta < t_exit) {
+                    t_exit = ta;
+                    exit_axis = a;
+                }
+            }
+            if (t_exit > max_distance) {
+                return false;
+            }
+            for (int a = 0; a < 3; ++a) {
+                if (a == exit_axis) {
+                    cell[a] = (step_dir[a] > 0) ? (chunk_min[a] + CHUNK_SIZE) : (chunk_min[a] - 1);
+                } else {
+                    // Stay inside the chunk on the other axes even if rounding says otherwise
+                    int c = (int)floorf(u[a] + d[a] * t_exit / step);
+                    if (c < chunk_min[a]) c = chunk_min[a];
+                    if (c > chunk_min[a] + CHUNK_SIZE - 1) c = chunk_min[a] + CHUNK_SIZE - 1;
+                    cell[a] = c;
+                }
+                t_max[a] = ray_axis_exit(u[a], d[a], cell[a], 1, step);
+            }
+            t = t_exit;
+            last_axis = exit_axis;
+            continue;
+        }
+
+        if (cube_map_get(&world->cubes, key)) {
+            result.hit = true;
+            result.key = key;
+            result.distance = t;
+            if (last_axis == 0) result.normal_x = -step_dir[0];
+            if (last_axis == 1) result.normal_y = -step_dir[1];
+            if (last_axis == 2) result.normal_z = -step_dir[2];
+            if (hit) {
+                *hit = result;
+            }
+            return true;
+        }
+
+        // Step into the neighbouring cell across the nearest boundary
+        int axis = (t_max[0] < t_max[1]) ? ((t_max[0] < t_max[2]) ? 0 : 2) : ((t_max[1] < t_max[2]) ? 1 : 2);
+        t = t_max[axis];
+        t_max[axis] += t_delta[axis];
+        cell[axis] += step_dir[axis];
+        last_axis = axis;
+    }
+    return false;
+}
+
+// Cast many rays against the same world, returns how many of them hit something
+size_t world_raycast_batch(const World* world, const Ray* rays, size_t count, Ray_Hit* hits) {
+    if (!rays || !hits) {
+        return 0;
+    }
+    size_t hit_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (world_raycast(world, rays[i].origin, rays[i].dir, rays[i].max_distance, &hits[i])) {
+            hit_count++;
+        }
+    }
+    return hit_count;
+}
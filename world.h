@@ -0,0 +1,42 @@
+// world.h - cube grid plus per-chunk bookkeeping and ray queries for 3dsdl
+#ifndef WORLD_H
+#define WORLD_H
+#include <stdint.h>
+#include "data_structures.h"
+
+// The world: cubes keyed by grid coordinate, plus the chunks they belong to.
+// Grid cell k is centered at k * step - offset on each axis (see create_ground_grid in main.c).
+// revision goes up with every change to the cubes, so renderers can tell whether anything moved.
+typedef struct {
+    Cube_Map cubes;
+    Chunk_Map chunks;
+    uint64_t revision;
+    float step;
+    float offset_x;
+    float offset_y;
+    float offset_z;
+} World;
+
+// Prototypes
+void init_world(World* world, size_t initial_capacity, float step, float offset_x, float offset_y, float offset_z);
+void free_world(World* world);
+Cube_Key world_chunk_key(Cube_Key cell);
+bool world_add_cube(World* world, Cube_Key key, Cube* cube);
+bool world_remove_cube(World* world, Cube_Key key);
+Cube* world_place_cube(World* world, Cube_Key key, SDL_Color color);
+void world_invalidate_cell(World* world, Cube_Key key);
+void world_mesh_chunk(const World* world, Chunk* chunk);
+const Chunk_Face* world_chunk_mesh(const Chunk* chunk, int level, size_t* face_count);
+AABB world_cell_aabb(const World* world, Cube_Key key);
+bool world_face_visible(const Chunk_Face* face, Point_3D eye);
+float world_face_shade(int normal_x, int normal_y, int normal_z);
+void world_insert_chunk_data(World* world, const Chunk_Data* data);
+size_t world_remove_chunk(World* world, Cube_Key chunk_key);
+void world_extract_chunk_data(const World* world, Cube_Key chunk_key, Chunk_Data* out);
+size_t world_mesh_dirty_chunks(World* world);
+Cube* world_get_cube(const World* world, Cube_Key key);
+Point_3D world_cell_center(const World* world, Cube_Key key);
+bool world_raycast(const World* world, Point_3D origin, Point_3D dir, float max_distance, Ray_Hit* hit);
+size_t world_raycast_batch(const World* world, const Ray* rays, size_t count, Ray_Hit* hits);
+
+#endif